@@ -0,0 +1,86 @@
+/**
+ * Benchmark of the small problems: solves per second of the first-order
+ * methods at n = 2 on the three paths of a run
+ *
+ * - run: operator(), on the std::function of the parameters and vector_type
+ *   (the path of the parsed expressions);
+ * - dynamic: minimize<0>(f, grad_f), on the callables and vector_type;
+ * - fixed: minimize(f, grad_f), on the callables and Eigen::Matrix<double, 2, 1>.
+ *
+ * Build with `make bench` and run `./bench/small_n [solves]`.
+ */
+#include <Methods>
+#include "fd_gradient.hpp"
+#include <chrono>
+#include <iomanip>
+
+// Solves per second of a run repeated `solves` times
+template <typename Run>
+double rate(int solves, Run &&run)
+{
+    vector_type x;
+    const auto begin = std::chrono::steady_clock::now();
+    {
+        SilentCout silent;
+        for (int k = 0; k < solves; ++k)
+            x = run();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    if (!((x - vector_type::Ones(2)).norm() < 1e-2))
+        std::cerr << "Warning: the run stopped at " << x.transpose() << std::endl;
+    return solves / elapsed.count();
+}
+
+// Times the three paths of a method
+template <typename M, typename P, typename F, typename G>
+void compare(const std::string &name, const P &params, const F &f, const G &grad_f, int solves)
+{
+    const M method(params);
+    const double run = rate(solves, [&]
+                            { return method(); });
+    const double dynamic = rate(solves, [&]
+                                { return method.template minimize<0>(f, grad_f); });
+    const double fixed = rate(solves, [&]
+                              { return method.minimize(f, grad_f); });
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << run << std::setw(12) << dynamic << std::setw(12) << fixed
+              << std::setprecision(2) << std::setw(10) << fixed / dynamic << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    const int solves = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    // Scaled Rosenbrock function (minimum at (1, 1)) and its gradient, on vectors of any type
+    auto f = [](const auto &x)
+    { return (1 - x(0)) * (1 - x(0)) + 5 * (x(1) - x(0) * x(0)) * (x(1) - x(0) * x(0)); };
+    auto grad_f = [](const auto &x)
+    {
+        std::decay_t<decltype(x)> grad(2);
+        grad << -2 * (1 - x(0)) - 20 * x(0) * (x(1) - x(0) * x(0)), 10 * (x(1) - x(0) * x(0));
+        return grad;
+    };
+    const scalar_function f_erased = f;
+    const vector_function grad_f_erased = grad_f;
+    vector_type x0(2);
+    x0 << -1, 2;
+
+    std::cout << "Solves per second at n = 2 (" << solves << " solves)" << std::endl;
+    std::cout << std::left << std::setw(20) << "method" << std::right << std::setw(12) << "run"
+              << std::setw(12) << "dynamic" << std::setw(12) << "fixed" << std::setw(10) << "speedup" << std::endl;
+
+    const GradientDescentParams gd(f_erased, grad_f_erased, x0, 1e-6, 1e-12, 0.05, 20000, 1e-10, 0.3, 0.01);
+    compare<GradientDescent<GradientDescentType::armijo>>("gradient (Armijo)", gd, f, grad_f, solves);
+    const HeavyBallParams hb(f_erased, grad_f_erased, x0, 1e-6, 1e-12, 0.05, 20000, 1e-10, 0.01, 0.5);
+    compare<HeavyBall<HeavyBallType::polyak, HeavyBallStrategy::constant>>("heavy ball (Polyak)", hb, f, grad_f, solves);
+    const NesterovParams nesterov(f_erased, grad_f_erased, x0, 1e-6, 1e-12, 0.05, 20000, 1e-10, 0.01, 0.5);
+    compare<Nesterov<NesterovType::polyak, NesterovStrategy::constant>>("Nesterov (Polyak)", nesterov, f, grad_f, solves);
+    const AdamParams adam(f_erased, grad_f_erased, x0, 1e-6, 1e-12, 0.05, 20000, 1e-10, 0.01, 0.9, 0.999);
+    compare<Adam<AdamType::constant>>("Adam", adam, f, grad_f, solves);
+
+    // Gradient by finite differences on the same paths
+    const auto fd_grad_f = small_gradient(f, 1e-6);
+    const GradientDescentParams gd_fd(f_erased, gradient<scalar_function, scalar_type>(f_erased, 1e-6), x0, 1e-6, 1e-12, 0.05, 20000, 1e-10, 0.3, 0.01);
+    compare<GradientDescent<GradientDescentType::armijo>>("gradient (FD)", gd_fd, f, fd_grad_f, solves);
+    return 0;
+}
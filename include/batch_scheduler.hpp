@@ -0,0 +1,87 @@
+#ifndef BATCH_SCHEDULER_HPP
+#define BATCH_SCHEDULER_HPP
+
+#include <Math>
+#include "method.hpp"
+#include <algorithm> // For std::erase_if
+#include <memory>    // For std::unique_ptr
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+/**
+ * \brief Scheduler of many runs (coroutines, see Method::solve) on a fixed number of threads
+ *
+ * The runs advance in rounds. In every round the running runs are resumed
+ * until their next evaluation of f or of its gradient (or their end), then
+ * the pending evaluations of all of them are gathered in a batch and
+ * evaluated, and the next round resumes them with the results. Both phases
+ * run in parallel in a task arena of the given number of threads, so
+ * thousands of small runs share a few threads instead of holding one each,
+ * and the evaluations of a round are spread evenly over the threads.
+ *
+ * Each request is evaluated with the function of its own run, so the runs
+ * must not share a callable object that is not thread safe (e.g. each solver
+ * has its own copy of f, as in the multi-start mode).
+ */
+class BatchScheduler
+{
+public:
+    /*!
+     * Constructor
+     *
+     * @param threads The number of threads (0 for the default number of TBB)
+     */
+    explicit BatchScheduler(int_type threads = 0)
+        : arena(threads > 0 ? threads : tbb::task_arena::automatic) {}
+
+    /*!
+     * Runs the coroutines to the end
+     *
+     * @param solves The coroutines of the runs (their methods must outlive the call)
+     * @return The final states of the runs, in the same order
+     */
+    std::vector<std::unique_ptr<State>> run(std::vector<Solve> &solves)
+    {
+        std::vector<Solve *> running;
+        for (Solve &solve : solves)
+            running.push_back(&solve);
+
+        arena.execute([&]
+                      {
+                          while (!running.empty())
+                          {
+                              // Resume every run until its next evaluation (or its end)
+                              tbb::parallel_for(std::size_t(0), running.size(), [&](std::size_t i)
+                                                { running[i]->resume(); });
+                              std::erase_if(running, [](const Solve *solve)
+                                            { return solve->done(); });
+                              if (running.empty())
+                                  break;
+
+                              // Evaluate the batch of the pending requests
+                              tbb::parallel_for(std::size_t(0), running.size(), [&](std::size_t i)
+                                                { running[i]->request().evaluate(); });
+                              ++batches;
+                              evaluations += running.size();
+                          } });
+
+        std::vector<std::unique_ptr<State>> states;
+        states.reserve(solves.size());
+        for (Solve &solve : solves)
+            states.push_back(solve.result());
+        return states;
+    }
+
+    //! Number of batches of evaluations
+    index_type get_batches() const { return batches; }
+
+    //! Total number of evaluations
+    index_type get_evaluations() const { return evaluations; }
+
+private:
+    tbb::task_arena arena;      // Threads of the scheduler
+    index_type batches = 0;     // Number of batches of evaluations
+    index_type evaluations = 0; // Total number of evaluations
+};
+
+#endif // BATCH_SCHEDULER_HPP
@@ -0,0 +1,28 @@
+#ifndef AUGMENTED_LAGRANGIAN_HPP
+#define AUGMENTED_LAGRANGIAN_HPP
+
+#include <Math>
+#include <Methods>
+
+/// @brief Constraints and options of the augmented Lagrangian driver
+struct AugmentedLagrangianOptions
+{
+    vector_function eq_constraints;        // Equality constraints h(x) = 0 (empty for none)
+    matrix_function jac_eq_constraints;    // Jacobian of h
+    vector_function ineq_constraints;      // Inequality constraints g(x) <= 0 (empty for none)
+    matrix_function jac_ineq_constraints;  // Jacobian of g
+    scalar_type penalty;                   // Initial penalty parameter rho
+    scalar_type penalty_growth;            // Factor of rho when the violation does not decrease enough
+    int_type outer_iterations;             // Maximum number of updates of the multipliers
+    scalar_type constraint_tolerance;      // Tolerance on the violation of the constraints
+};
+
+/// @brief Minimizes f subject to the constraints with an augmented Lagrangian outer loop around a method
+/// @param params parameters of the unconstrained method (f is replaced by the augmented Lagrangian)
+/// @param method_t primary method type
+/// @param method_s secondary strategy (only for some methods)
+/// @param options constraints and options of the augmented Lagrangian driver
+void run_augmented_lagrangian(const Params &params, const string_type &method_t, const string_type &method_s,
+                              const AugmentedLagrangianOptions &options);
+
+#endif // AUGMENTED_LAGRANGIAN_HPP
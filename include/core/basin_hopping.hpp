@@ -0,0 +1,27 @@
+#ifndef BASIN_HOPPING_HPP
+#define BASIN_HOPPING_HPP
+
+#include <Math>
+#include <Methods>
+
+/// @brief Options of the basin hopping driver
+struct BasinHoppingOptions
+{
+    int_type hops;               // Number of hops (perturbation + local solve) of each chain
+    scalar_type step_size;       // Half width of the random perturbations
+    scalar_type temperature;     // Temperature of the Metropolis test (of the coldest chain)
+    int_type chains;             // Number of chains (parallel tempering)
+    scalar_type max_temperature; // Temperature of the hottest chain (parallel tempering)
+    int_type swap_interval;      // Hops between two rounds of swaps (parallel tempering)
+};
+
+/// @brief Runs basin hopping (or parallel tempering) with a local method and prints the best minimum found
+/// @param params parameters of the local method (the initial condition is the first point of the chains)
+/// @param method_t primary type of the local method
+/// @param method_s secondary strategy of the local method (only for some methods)
+/// @param hopping_t variant ("Basin hopping" or "Parallel tempering")
+/// @param options options of the basin hopping driver
+void run_basin_hopping(const Params &params, const string_type &method_t, const string_type &method_s,
+                       const string_type &hopping_t, const BasinHoppingOptions &options);
+
+#endif // BASIN_HOPPING_HPP
@@ -0,0 +1,26 @@
+#ifndef MULTISTART_HPP
+#define MULTISTART_HPP
+
+#include <Math>
+#include <Methods>
+
+/// @brief Options of the multi-start driver
+struct MultiStartOptions
+{
+    vector_type lower_bounds;   // Lower corner of the box of the starting points
+    vector_type upper_bounds;   // Upper corner of the box of the starting points
+    int_type starts;            // Number of starting points
+    int_type prune_interval;    // Evaluations of f between two pruning checks of a start (0 to never prune)
+    scalar_type cluster_radius; // Minima closer than this are considered the same minimum
+    int_type scheduler_threads; // Threads of the coroutine scheduler of the starts (0 for a task per start)
+};
+
+/// @brief Runs a local method from several starting points in parallel and prints the distinct minima found
+/// @param params parameters of the method (the initial condition is replaced by the starting points)
+/// @param method_t primary method type
+/// @param method_s secondary strategy (only for some methods)
+/// @param options options of the multi-start driver
+void run_multistart(const Params &params, const string_type &method_t, const string_type &method_s,
+                    const MultiStartOptions &options);
+
+#endif // MULTISTART_HPP
@@ -6,8 +6,23 @@
 #include "muparserx_interface.hpp"
 #include "fd_gradient.hpp"
 #include "fd_hessian.hpp"
+#include "fd_jacobian.hpp"
+#include "dependencies.hpp"
+#include "stochastic_objective.hpp"
+#include "multistart.hpp"
+#include "basin_hopping.hpp"
+#include "augmented_lagrangian.hpp"
+#include "sweep.hpp"
 
 void read(const GetPot &datafile, Params &params);
 
+void read(const GetPot &datafile, MultiStartOptions &options);
+
+void read(const GetPot &datafile, BasinHoppingOptions &options);
+
+void read(const GetPot &datafile, AugmentedLagrangianOptions &options);
+
+void read(const GetPot &datafile, SweepOptions &options);
+
 #endif //READNEW_HPP
 
@@ -3,6 +3,8 @@
 
 #include <Math>
 #include <Methods>
+#include <functional> // For std::function
+#include <memory>     // For std::unique_ptr
 
 /// @brief Prints the computed minimum, function value at the minimum, and gradient norm at the minimum
 /// @param minimum computed minimum
@@ -15,6 +17,18 @@ void print_result(const vector_type &minimum,
                   
 void run_solver(const Method &solver);
 
+/// @brief Builds the solver selected by the type of the parameters and the method strings
+/// @param params parameters of the method
+/// @param method_t primary method type
+/// @param method_s secondary strategy (only for some methods)
+/// @param adjust modification of the copy of the parameters stored in the solver (e.g. the initial condition)
+/// @return the solver, or nullptr if the method type is invalid
+std::unique_ptr<Method> make_solver(const Params &params, const string_type &method_t, const string_type &method_s = "",
+                                    const std::function<void(Params &)> &adjust = nullptr);
+
+/// @brief Prints the registered methods and their variants (see SolverRegistry)
+void print_methods();
+
 void run(const Params &params, const string_type &method_t, const string_type &method_s = "");
 
 #endif // READ_HPP
\ No newline at end of file
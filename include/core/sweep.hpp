@@ -0,0 +1,34 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <Math>
+#include <Methods>
+
+/// @brief Objective of a sweep, f and its gradient, with the setter of the parameter they share
+struct ParametricObjective
+{
+    scalar_function f;                             // Function f(x; p)
+    vector_function grad_f;                        // Gradient of f with respect to x
+    std::function<void(scalar_type)> set_parameter; // Sets p in f, in its gradient and in all their copies
+};
+
+/// @brief Options of the parameter sweep driver
+struct SweepOptions
+{
+    string_type parameter;                          // Name of the parameter p in the expressions
+    scalar_type start;                              // First value of p
+    scalar_type end;                                // Last value of p
+    int_type points;                                // Number of values of p (evenly spaced)
+    int_type segments;                              // Number of segments of the range solved in parallel
+    std::function<ParametricObjective()> objective; // New objective with its own parameter (one for each segment)
+};
+
+/// @brief Minimizes f(x; p) for a range of values of a parameter p, with warm starts, and prints the minimizers
+/// @param params parameters of the method (f and its gradient are replaced by the parametric ones)
+/// @param method_t primary method type
+/// @param method_s secondary strategy (only for some methods)
+/// @param options options of the sweep driver
+void run_sweep(const Params &params, const string_type &method_t, const string_type &method_s,
+               const SweepOptions &options);
+
+#endif // SWEEP_HPP
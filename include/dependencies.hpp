@@ -0,0 +1,207 @@
+#ifndef DEPENDENCIES_HPP
+#define DEPENDENCIES_HPP
+
+#include <Math>
+#include <algorithm> // For std::stable_sort
+#include <cctype>    // For std::isspace, std::isdigit
+#include <numeric>   // For std::iota
+#include <regex>
+#include <set>
+
+// Structure of a muparserx expression f(x) = sum of terms
+// The dependency information is obtained from the text of the expression,
+// so it is available before any evaluation.
+
+// An additive term of an expression and the components of x it depends on
+struct Term
+{
+    string_type expression;            // Expression of the term (without the operator before it)
+    bool negative;                     // True if the term is subtracted from the previous ones
+    std::vector<index_type> variables; // Sorted indices i of the x[i] appearing in the term
+};
+
+/**
+ * Indices of the components of x appearing in an expression.
+ *
+ * @param expression A muparserx expression in the variable x
+ * @return The sorted indices i of the x[i] appearing in the expression
+ */
+inline std::vector<index_type> variables(const string_type &expression)
+{
+    static const std::regex component(R"(\bx\s*\[\s*(\d+)\s*\])");
+    std::set<index_type> indices;
+    for (auto it = std::sregex_iterator(expression.begin(), expression.end(), component); it != std::sregex_iterator(); ++it)
+        indices.insert(std::stol((*it)[1].str()));
+    return {indices.begin(), indices.end()};
+}
+
+/**
+ * Split an expression in its additive terms.
+ *
+ * The expression is split at the '+' and '-' that are outside of any
+ * bracket and that are binary operators (not signs, nor exponents of
+ * numbers like 1e-3).
+ *
+ * @param expression A muparserx expression in the variable x
+ * @return The terms of the expression, whose (signed) sum is the expression
+ */
+inline std::vector<Term> additive_terms(const string_type &expression)
+{
+    std::vector<Term> terms;
+    int depth = 0;
+    bool negative = false;
+    string_type current;
+
+    // Last non blank character before position i (0 if none)
+    auto previous = [&](std::size_t i) -> char
+    {
+        while (i > 0)
+        {
+            --i;
+            if (!std::isspace(static_cast<unsigned char>(expression[i])))
+                return expression[i];
+        }
+        return 0;
+    };
+    // True if the 'e' or 'E' at position i is the exponent of a number
+    auto exponent = [&](std::size_t i) -> bool
+    {
+        std::size_t j = i;
+        while (j > 0 && (std::isdigit(static_cast<unsigned char>(expression[j - 1])) || expression[j - 1] == '.'))
+            --j;
+        return j < i && (j == 0 || !(std::isalnum(static_cast<unsigned char>(expression[j - 1])) || expression[j - 1] == '_'));
+    };
+    auto push = [&]()
+    {
+        if (current.find_first_not_of(" \t") != string_type::npos)
+            terms.push_back({current, negative, variables(current)});
+        current.clear();
+    };
+
+    for (std::size_t i = 0; i < expression.size(); ++i)
+    {
+        const char c = expression[i];
+        if (c == '(' || c == '[' || c == '{')
+            ++depth;
+        else if (c == ')' || c == ']' || c == '}')
+            --depth;
+        else if (depth == 0 && (c == '+' || c == '-'))
+        {
+            const char p = previous(i);
+            const bool sign = p == 0 || string_type("(*/^,+-=<>!&|?:").find(p) != string_type::npos;
+            const bool number = (p == 'e' || p == 'E') && exponent(expression.find_last_of(p, i));
+            if (!sign && !number)
+            {
+                push();
+                negative = (c == '-');
+                continue;
+            }
+        }
+        current += c;
+    }
+    push();
+    return terms;
+}
+
+/**
+ * Split a list expression in its elements.
+ *
+ * @param expression A muparserx list like "{x[0]^2, sin(x[1]), 1}"
+ * @return The expressions of the elements (split at the commas outside of
+ * any inner bracket); an expression without braces is a list of one element
+ */
+inline std::vector<string_type> list_elements(const string_type &expression)
+{
+    const std::size_t first = expression.find_first_not_of(" \t");
+    const std::size_t last = expression.find_last_not_of(" \t");
+    if (first == string_type::npos)
+        return {};
+    if (expression[first] != '{' || expression[last] != '}')
+        return {expression};
+
+    std::vector<string_type> elements;
+    string_type current;
+    int depth = 0;
+    for (std::size_t i = first + 1; i < last; ++i)
+    {
+        const char c = expression[i];
+        if (c == '(' || c == '[' || c == '{')
+            ++depth;
+        else if (c == ')' || c == ']' || c == '}')
+            --depth;
+        else if (depth == 0 && c == ',')
+        {
+            elements.push_back(current);
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    if (current.find_first_not_of(" \t") != string_type::npos)
+        elements.push_back(current);
+    return elements;
+}
+
+/**
+ * Group blocks of coordinates so that blocks in the same group share no term.
+ *
+ * Two blocks conflict if some term of the expression depends on
+ * coordinates of both. The conflict graph is colored greedily (blocks with
+ * more conflicts first), so the blocks of a color can be updated at the
+ * same time without any interaction.
+ *
+ * @param blocks A partition of the coordinates in blocks
+ * @param terms The additive terms of the objective
+ * @param n The number of coordinates
+ * @return The colors, each one is the list of the indices of its blocks
+ */
+inline std::vector<std::vector<index_type>> color_blocks(const std::vector<std::vector<index_type>> &blocks,
+                                                         const std::vector<Term> &terms, index_type n)
+{
+    // Block of each coordinate
+    std::vector<index_type> owner(n, -1);
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+        for (index_type i : blocks[b])
+            owner[i] = b;
+
+    // Conflict graph
+    std::vector<std::set<index_type>> conflicts(blocks.size());
+    for (const Term &term : terms)
+    {
+        std::set<index_type> touched;
+        for (index_type i : term.variables)
+            if (i < n && owner[i] >= 0)
+                touched.insert(owner[i]);
+        for (index_type a : touched)
+            for (index_type b : touched)
+                if (a != b)
+                    conflicts[a].insert(b);
+    }
+
+    // Greedy coloring, blocks with more conflicts first
+    std::vector<index_type> order(blocks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](index_type a, index_type b)
+                     { return conflicts[a].size() > conflicts[b].size(); });
+    std::vector<index_type> color(blocks.size(), -1);
+    std::vector<std::vector<index_type>> colors;
+    for (index_type b : order)
+    {
+        std::set<index_type> used;
+        for (index_type c : conflicts[b])
+            if (color[c] >= 0)
+                used.insert(color[c]);
+        index_type k = 0;
+        while (used.count(k))
+            ++k;
+        color[b] = k;
+        if (k == static_cast<index_type>(colors.size()))
+            colors.emplace_back();
+        colors[k].push_back(b);
+    }
+    for (auto &group : colors)
+        std::sort(group.begin(), group.end());
+    return colors;
+}
+
+#endif // DEPENDENCIES_HPP
@@ -86,4 +86,57 @@ std::function<vector_type(const vector_type &)> gradient(const F &f, const T &h)
   };
 }
 
+/// @brief This function computes the gradient of a real valued function by finite differences, for small problems
+/// @tparam DT is the difference type: forward, backward or centered
+/// @tparam F is the callable object, callable on the vectors of the points
+/// @param f is the callable object
+/// @param h is the step for computing the gradient
+/// @return a generic callable object grad(x), for x a vector_type or an Eigen::Matrix<scalar_type, N, 1>
+/// @note the components are computed sequentially on a copy of x of the same type, so a fixed-size x is
+/// never copied to the heap (see the minimize methods of the first-order methods); f(x) is evaluated
+/// once for the forward and backward differences
+/*
+ * Example usage: the gradient of a generic lambda, on a point of dimension 2
+ * auto f = [](const auto &x) { return std::sin(x(0)) + std::sin(x(1)); };
+ * auto d = small_gradient(f, 1.e-4);
+ * Eigen::Vector2d g = d(Eigen::Vector2d(0.0, 0.0));
+ */
+template <typename DT = DifferenceType::Centered, typename F>
+auto small_gradient(const F &f, scalar_type h)
+{
+  return [=](const auto &x)
+  {
+    using Vector = std::decay_t<decltype(x)>;
+    Vector grad = Vector::Zero(x.size());
+    Vector y = x;
+    scalar_type fx = 0.0;
+    if constexpr (!std::is_same_v<DT, DifferenceType::Centered>)
+      fx = f(x);
+
+    for (index_type i = 0; i < x.size(); ++i)
+    {
+      const scalar_type x_i = y(i);
+      if constexpr (std::is_same_v<DT, DifferenceType::Forward>)
+      {
+        y(i) = x_i + h;
+        grad(i) = (f(y) - fx) / h;
+      }
+      else if constexpr (std::is_same_v<DT, DifferenceType::Backward>)
+      {
+        y(i) = x_i - h;
+        grad(i) = (fx - f(y)) / h;
+      }
+      else
+      { // Centered
+        y(i) = x_i + h;
+        const scalar_type forward = f(y);
+        y(i) = x_i - h;
+        grad(i) = (forward - f(y)) / (2 * h);
+      }
+      y(i) = x_i;
+    }
+    return grad;
+  };
+}
+
 #endif // FD_GRADIENT_HPP
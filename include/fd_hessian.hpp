@@ -53,4 +53,58 @@
  }
  
 
+/// @brief This function computes the Hessian of a real valued function by centered second differences, for
+/// small problems
+/// @tparam F is the callable object, callable on the vectors of the points
+/// @param f is the callable object
+/// @param h is the step for computing the Hessian
+/// @return a generic callable object hess(x), for x a vector_type or an Eigen::Matrix<scalar_type, N, 1>, that
+/// returns an Eigen::Matrix<scalar_type, N, N> (a matrix_type for a vector_type)
+/// @note the entries are computed sequentially on a copy of x of the same type, so with fixed-size vectors
+/// nothing is allocated on the heap; the diagonal uses f(x +- h e_i) and the other entries the four points
+/// x +- h e_i +- h e_j (2 n^2 + 1 evaluations of f, instead of the nested gradients of hessian)
+/*
+ * Example usage: the Hessian of sin(x) + sin(y) at x0 = (0, 0)
+ * auto f = [](const auto &x) { return std::sin(x(0)) + std::sin(x(1)); };
+ * auto H = small_hessian(f, 1.e-4);
+ * Eigen::Matrix2d d = H(Eigen::Vector2d(0.0, 0.0));
+ */
+template <typename F>
+auto small_hessian(const F &f, scalar_type h)
+{
+  return [=](const auto &x)
+  {
+    using Vector = std::decay_t<decltype(x)>;
+    using Hessian = Eigen::Matrix<scalar_type, Vector::RowsAtCompileTime, Vector::RowsAtCompileTime>;
+    const index_type n = x.size();
+    Hessian hess(n, n);
+    Vector y = x;
+    const scalar_type fx = f(x);
+    for (index_type i = 0; i < n; ++i)
+    {
+      const scalar_type x_i = y(i);
+      y(i) = x_i + h;
+      const scalar_type forward = f(y);
+      y(i) = x_i - h;
+      hess(i, i) = (forward - 2 * fx + f(y)) / (h * h);
+      for (index_type j = i + 1; j < n; ++j)
+      {
+        const scalar_type x_j = y(j);
+        scalar_type sum = 0.0;
+        for (const scalar_type s_i : {1.0, -1.0})
+          for (const scalar_type s_j : {1.0, -1.0})
+          {
+            y(i) = x_i + s_i * h;
+            y(j) = x_j + s_j * h;
+            sum += s_i * s_j * f(y);
+          }
+        y(j) = x_j;
+        hess(i, j) = hess(j, i) = sum / (4 * h * h);
+      }
+      y(i) = x_i;
+    }
+    return hess;
+  };
+}
+
 #endif // FD_HESSIAN_HPP
\ No newline at end of file
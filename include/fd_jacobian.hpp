@@ -0,0 +1,143 @@
+#ifndef FD_JACOBIAN_HPP
+#define FD_JACOBIAN_HPP
+
+#include "fd_gradient.hpp"
+#include <memory>                          // For std::shared_ptr
+#include <tbb/enumerable_thread_specific.h> // For per-thread copies of the function
+
+/**
+ * Compute the Jacobian of a vector valued function by finite differences
+ *
+ * @brief Compute the Jacobian of a vector valued function by finite differences
+ * @tparam F is the callable object of signature vector_type (const vector_type &)
+ * @tparam T is the type of the step
+ * @tparam DT is the difference type: forward, backward or centered
+ * @param f the function to compute the Jacobian of
+ * @param h the step for computing the Jacobian
+ * @return a callable object of signature matrix_type (const vector_type &)
+ * @note the columns of the Jacobian are computed in parallel, each thread
+ * works on its own copy of f (a muparserx engine cannot be evaluated by
+ * two threads at the same time)
+ * @note forward and backward differences evaluate f(x) only once
+ * @warning it does not check if the input function is valid
+ * @warning it does not check if the step is valid
+ * @example Computing the Jacobian of (x0*x1, sin(x0)) at x0 = (1, 0)
+ * auto r = [](const vector_type &x) { return vector_type{{x(0) * x(1), std::sin(x(0))}}; };
+ * auto J = jacobian<decltype(r), double, DifferenceType::Centered>(r, 1.e-4);
+ * auto d = J(x0); // 2x2 matrix
+ */
+template <typename F, typename T, typename DT = DifferenceType::Centered>
+std::function<matrix_type(const vector_type &)> jacobian(const F &f, const T &h)
+{
+  // Copies are made once per thread and shared by all the copies of the returned callable
+  auto local_f = std::make_shared<tbb::enumerable_thread_specific<F>>(f);
+
+  return [=](const vector_type &x) -> matrix_type
+  {
+    const index_type n = x.size();
+    vector_type fx;
+    if constexpr (!std::is_same_v<DT, DifferenceType::Centered>)
+    {
+      fx = local_f->local()(x);
+    }
+
+    std::vector<index_type> indices(n);
+    std::iota(indices.begin(), indices.end(), 0); // Fill indices with 0, 1, ..., n-1
+    std::vector<vector_type> columns(n);
+
+    // Lambda function to compute a single column of the Jacobian
+    auto compute_single_column = [&x, &h, &fx, local_f](index_type j)
+    {
+      F &fj = local_f->local();
+      vector_type x_step = x;
+
+      if constexpr (std::is_same_v<DT, DifferenceType::Forward>)
+      {
+        x_step(j) += h;
+        return vector_type((fj(x_step) - fx) / h); // column j
+      }
+      else if constexpr (std::is_same_v<DT, DifferenceType::Backward>)
+      {
+        x_step(j) -= h;
+        return vector_type((fx - fj(x_step)) / h); // column j
+      }
+      else
+      { // Centered
+        x_step(j) += h;
+        vector_type f_forward = fj(x_step);
+        x_step(j) -= 2 * h;
+        return vector_type((f_forward - fj(x_step)) / (2 * h)); // column j
+      }
+    };
+
+    // Parallel execution using std::transform with std::execution::par
+    std::transform(std::execution::par, indices.begin(), indices.end(), columns.begin(), compute_single_column);
+
+    matrix_type jac(n > 0 ? columns[0].size() : 0, n);
+    for (index_type j = 0; j < n; ++j)
+      jac.col(j) = columns[j];
+
+    return jac;
+  };
+}
+
+/// @brief This function computes the Jacobian of a vector valued function by finite differences, for small problems
+/// @tparam DT is the difference type: forward, backward or centered
+/// @tparam F is the callable object, callable on the vectors of the points
+/// @param f is the callable object
+/// @param h is the step for computing the Jacobian
+/// @return a generic callable object jac(x), for x a vector_type or an Eigen::Matrix<scalar_type, N, 1>; the
+/// Jacobian has as many rows as f(x) (fixed if f returns a fixed-size vector) and as many columns as x
+/// @note the columns are computed sequentially on a copy of x of the same type, so with fixed-size vectors
+/// nothing is allocated on the heap; f(x) is evaluated once for the forward and backward differences
+/*
+ * Example usage: the Jacobian of (x0*x1, sin(x0)) at x0 = (1, 0)
+ * auto r = [](const auto &x) { return Eigen::Vector2d(x(0) * x(1), std::sin(x(0))); };
+ * auto J = small_jacobian(r, 1.e-4);
+ * Eigen::Matrix2d d = J(Eigen::Vector2d(1.0, 0.0));
+ */
+template <typename DT = DifferenceType::Centered, typename F>
+auto small_jacobian(const F &f, scalar_type h)
+{
+  return [=](const auto &x)
+  {
+    using Vector = std::decay_t<decltype(x)>;
+    using Value = std::decay_t<decltype(f(x))>;
+    using Jacobian = Eigen::Matrix<scalar_type, Value::RowsAtCompileTime, Vector::RowsAtCompileTime>;
+    Vector y = x;
+    Value fx;
+    if constexpr (!std::is_same_v<DT, DifferenceType::Centered>)
+      fx = f(x);
+
+    Jacobian jac;
+    for (index_type j = 0; j < x.size(); ++j)
+    {
+      const scalar_type x_j = y(j);
+      Value column;
+      if constexpr (std::is_same_v<DT, DifferenceType::Forward>)
+      {
+        y(j) = x_j + h;
+        column = (f(y) - fx) / h;
+      }
+      else if constexpr (std::is_same_v<DT, DifferenceType::Backward>)
+      {
+        y(j) = x_j - h;
+        column = (fx - f(y)) / h;
+      }
+      else
+      { // Centered
+        y(j) = x_j + h;
+        const Value forward = f(y);
+        y(j) = x_j - h;
+        column = (forward - f(y)) / (2 * h);
+      }
+      y(j) = x_j;
+      if (j == 0)
+        jac.resize(column.size(), x.size());
+      jac.col(j) = column;
+    }
+    return jac;
+  };
+}
+
+#endif // FD_JACOBIAN_HPP
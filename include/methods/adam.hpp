@@ -2,6 +2,7 @@
 #define ADAM_HPP
 
 #include "method.hpp"
+#include "registry.hpp"
 
 // Parameters for the gradient descent algorithm
 struct AdamParams : public Params
@@ -10,13 +11,14 @@ struct AdamParams : public Params
     AdamParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
                scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
                int_type max_iterations, scalar_type minimum_step,
-               scalar_type mu, scalar_type beta1, scalar_type beta2)
+               scalar_type mu, scalar_type beta1, scalar_type beta2, Box box = Box())
         : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
                  initial_step, max_iterations, minimum_step),
-          mu(mu), beta1(beta1), beta2(beta2) {}
+          mu(mu), beta1(beta1), beta2(beta2), box(box) {}
     scalar_type mu;    // Parameter for the exponential decay and the inverse decay
     scalar_type beta1; // Exponential decay rate for 1st moment estimate
     scalar_type beta2; // Exponential decay rate for 2nd moment estimate
+    Box box;           // Bounds of the projected variant (empty for none)
 };
 
 // Descent types
@@ -26,6 +28,17 @@ enum class AdamType
     constant
 };
 
+// State of a run of Adam
+template <typename Vector = vector_type>
+struct AdamState : public BasicState<Vector>
+{
+    scalar_type alpha;      // Step size
+    Vector m;               // First moment estimate
+    Vector v;               // Second moment estimate
+    scalar_type beta1_iter; // beta1 elevated to the number of iterations
+    scalar_type beta2_iter; // beta2 elevated to the number of iterations
+};
+
 // Adam algorithm
 template <AdamType T>
 class Adam : public Method
@@ -35,13 +48,24 @@ public:
     // Constructor with parameters
     Adam(const AdamParams &params) : Method(params), params(params) {}
 
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<AdamState<>>();
+        initialize(*state);
+        return state;
+    }
+
     /**
-     * Run the Adam algorithm.
+     * One iteration of the Adam algorithm (operator() loops over it until the
+     * run stops).
      *
-     * @return The converged solution
+     * @param base The state of the run, created by start
      *
      * @note The algorithm stops when the norm of the gradient is less than
-     * `tolerance_r` or when the step size is less than `tolerance_s`.
+     * `tolerance_r` or when the step size is less than `tolerance_s`. With
+     * bounds every update is projected on the box and the norm of the
+     * projected gradient replaces the norm of the gradient.
      *
      * @note The algorithm uses a dynamic step size based on the moment estimates
      * of the gradient, which are computed using the following formulas:
@@ -58,33 +82,133 @@ public:
      *
      * @note The algorithm also uses a small number \f$ \epsilon \f$ to avoid division by zero.
      */
-    vector_type operator()() const override
+    void step(State &base) const override
+    {
+        iterate(static_cast<AdamState<> &>(base), DirectEvaluator{params.f, params.grad_f}, true).get();
+    };
+
+    /**
+     * Coroutine of a run of the Adam algorithm: the iterations of step,
+     * suspended at every evaluation of the gradient (Adam never evaluates f).
+     */
+    Solve solve() const override
+    {
+        std::unique_ptr<State> base = start();
+        co_await iterate(static_cast<AdamState<> &>(*base), SuspendingEvaluator{params.f, params.grad_f}, false);
+        co_return std::move(base);
+    }
+
+    /**
+     * Run the Adam algorithm on a gradient of any type (e.g. a lambda)
+     * instead of the std::function of the parameters, which are ignored. The
+     * iterations are instantiated on G, so the compiler can inline the
+     * evaluations into them, and on fixed-size vectors for problems of
+     * dimension up to max_fixed_dimension (see dispatch_dimension), so their
+     * temporaries are not allocated on the heap.
+     *
+     * @tparam max_fixed The largest dimension run on fixed-size vectors (0
+     * to run on vector_type, e.g. to compare the two paths)
+     * @param f The function (not evaluated by Adam, taken for the same
+     * interface as the other first-order methods)
+     * @param grad_f The gradient of the function, callable as grad_f(x) with
+     * x a vector_type or an Eigen::Matrix<scalar_type, N, 1>
+     * @return The last point of the run
+     */
+    template <int_type max_fixed = max_fixed_dimension, typename F, typename G>
+    vector_type minimize(const F &f, const G &grad_f) const
+    {
+        return dispatch_dimension<max_fixed>(params.initial_condition.size(), [&]<int N>()
+                                  {
+                                      AdamState<Eigen::Matrix<scalar_type, N, 1>> state;
+                                      initialize(state);
+                                      iterate(state, DirectEvaluator{f, grad_f}, false).get();
+                                      std::cout << state.message << std::endl;
+                                      return vector_type(state.x); });
+    }
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    scalar_type get_mu() const { return params.mu; }
+    scalar_type get_beta1() const { return params.beta1; }
+    scalar_type get_beta2() const { return params.beta2; }
+
+    /**
+     * Print the parameters of this method.
+     *
+     * The parameters are: initial condition, tolerance_r, tolerance_s,
+     * initial step, maximum iterations, minimum step, mu, beta1, and beta2.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the descent strategy at compile time
+        if constexpr (T == AdamType::dynamic)
+        {
+            std::cout << "Descend type: dynamic decay of the step size" << std::endl;
+        }
+        else if constexpr (T == AdamType::constant)
+        {
+            std::cout << "Descend type: constant step size" << std::endl;
+        }
+        Method::print();
+        params.box.print();
+        std::cout << "mu: " << params.mu << std::endl;
+        std::cout << "beta1: " << params.beta1 << std::endl;
+        std::cout << "beta2: " << params.beta2 << std::endl;
+    };
+
+private:
+    // Initial condition, step size and moment estimates of a run
+    template <typename Vector>
+    void initialize(AdamState<Vector> &state) const
+    {
+        state.x = params.box.project(params.initial_condition);
+        state.alpha = params.initial_step;
+        state.m = Vector::Zero(state.x.size());
+        state.v = Vector::Zero(state.x.size());
+        state.beta1_iter = params.beta1;
+        state.beta2_iter = params.beta2;
+    }
+
+    /**
+     * Iterations of a run, until it stops (only one if once is true). The
+     * evaluations of the gradient are awaited from the evaluator: made at
+     * once for step and minimize (DirectEvaluator, on the callable of the
+     * parameters or on any callable), suspending the run for solve
+     * (SuspendingEvaluator).
+     */
+    template <typename Vector, typename E>
+    Task<> iterate(AdamState<Vector> &state, E evaluator, bool once) const
     {
-        vector_type x = vector_type::Map(params.initial_condition.data(), params.initial_condition.size());
-        scalar_type alpha = params.initial_step;
-        vector_type epsilon = vector_type::Ones(x.size()) * 1e-8; // small number to avoid division by zero
-        vector_type m = vector_type::Zero(x.size());              // first moment estimate
-        vector_type mhat = vector_type::Zero(x.size());           // 1st moment estimate normalised
-        vector_type v = vector_type::Zero(x.size());              // second moment estimate
-        vector_type vhat = vector_type::Zero(x.size());           // 2nd moment estimate normalised
-        scalar_type beta1_iter = params.beta1;                    // beta1 elevated to the number of iterations
-        scalar_type beta2_iter = params.beta2;                    // beta2 elevated to the number of iterations
-        index_type iteration = 0;
-
-        for (iteration = 0; iteration < params.max_iterations; ++iteration)
+        Vector &x = state.x;
+        Vector &m = state.m;
+        Vector &v = state.v;
+        scalar_type &alpha = state.alpha;
+        scalar_type &beta1_iter = state.beta1_iter;
+        scalar_type &beta2_iter = state.beta2_iter;
+
+        const Vector epsilon = Vector::Ones(x.size()) * 1e-8; // small number to avoid division by zero
+        Vector mhat;                                          // 1st moment estimate normalised
+        Vector vhat;                                          // 2nd moment estimate normalised
+        do
         {
+            if (state.iteration >= params.max_iterations)
+            {
+                state.not_converged();
+                break;
+            }
+
             // Compute the gradient at the current point
-            vector_type grad = vector_type::Map(params.grad_f(x).data(), params.grad_f(x).size());
+            const Vector grad = co_await evaluator.gradient(x);
 
-            // Check for convergence (norm of the gradient)
-            scalar_type residual = grad.norm();
+            // Check for convergence (norm of the gradient, projected on the box if there are bounds)
+            scalar_type residual = params.box.residual(x, grad);
             if (residual < params.tolerance_r)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to residual criterion." << std::endl;
+                state.converged("residual");
                 break;
             }
 
-            vector_type x_prev = x;
+            Vector x_prev = x;
 
             // Update the current point and auxiliary elements
             m = params.beta1 * m + (1 - params.beta1) * grad;
@@ -105,7 +229,8 @@ public:
                 // if constexpr (T == AdamType::constant) // not needed
             }
 
-            x = x - alpha * (mhat.array() / (vhat.array().sqrt() + epsilon.array())).matrix();
+            // Update the current point (projected on the box in the same loop)
+            params.box.assign(x, x - alpha * (mhat.array() / (vhat.array().sqrt() + epsilon.array())).matrix());
 
             beta1_iter *= params.beta1;
             beta2_iter *= params.beta2;
@@ -114,48 +239,23 @@ public:
             scalar_type step_size = (x - x_prev).norm();
             if (step_size < params.tolerance_s)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to step size criterion." << std::endl;
+                state.converged("step size");
                 break;
             }
-        }
-
-        if (iteration == params.max_iterations)
-            std::cout << "Not converged (max_iteration = " << iteration << ")" << std::endl;
-
-        return x;
-    };
-
-    // Getters
-    const Params &get_params() const override { return params; }
-    scalar_type get_mu() const { return params.mu; }
-    scalar_type get_beta1() const { return params.beta1; }
-    scalar_type get_beta2() const { return params.beta2; }
-
-    /**
-     * Print the parameters of this method.
-     *
-     * The parameters are: initial condition, tolerance_r, tolerance_s,
-     * initial step, maximum iterations, minimum step, mu, beta1, and beta2.
-     */
-    void print() const override
-    {
-        // Use constexpr if to select the descent strategy at compile time
-        if constexpr (T == AdamType::dynamic)
-        {
-            std::cout << "Descend type: dynamic decay of the step size" << std::endl;
-        }
-        else if constexpr (T == AdamType::constant)
-        {
-            std::cout << "Descend type: constant step size" << std::endl;
-        }
-        Method::print();
-        std::cout << "mu: " << params.mu << std::endl;
-        std::cout << "beta1: " << params.beta1 << std::endl;
-        std::cout << "beta2: " << params.beta2 << std::endl;
-    };
+            ++state.iteration;
+        } while (!once && !state.done);
+    }
 
-private:
     AdamParams params;
 };
 
+// Variants of Adam in the solver registry (adam_t)
+inline const bool adam_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<Adam<AdamType::dynamic>, AdamParams>("adam", "Dynamic");
+    registry.add<Adam<AdamType::constant>, AdamParams>("adam", "Constant");
+    return true;
+}();
+
 #endif // ADAM_HPP
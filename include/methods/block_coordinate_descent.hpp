@@ -0,0 +1,290 @@
+#ifndef BLOCK_COORDINATE_DESCENT_HPP
+#define BLOCK_COORDINATE_DESCENT_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <random>
+#include <tbb/parallel_for.h>
+
+// Parameters for the block coordinate descent algorithm
+struct BlockCoordinateDescentParams : public Params
+{
+    BlockCoordinateDescentParams() = default;
+    // Constructor for BlockCoordinateDescentParams
+    BlockCoordinateDescentParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                                 scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                                 int_type max_iterations, scalar_type minimum_step,
+                                 std::vector<std::vector<index_type>> blocks,
+                                 std::vector<std::vector<index_type>> colors,
+                                 std::vector<scalar_function> block_functions,
+                                 scalar_type h, scalar_type sigma)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          blocks(blocks), colors(colors), block_functions(block_functions), h(h), sigma(sigma) {}
+    std::vector<std::vector<index_type>> blocks;  // Partition of the coordinates in blocks
+    std::vector<std::vector<index_type>> colors;  // Groups of blocks that share no term of f
+    std::vector<scalar_function> block_functions; // Terms of f that depend on each block
+    scalar_type h;                                // Step for the partial derivatives
+    scalar_type sigma;                            // Parameter for the Armijo rule
+};
+
+// Block selection rules
+enum class BlockCoordinateDescentType
+{
+    cyclic,
+    random,
+    gauss_southwell
+};
+
+// State of a run of block coordinate descent
+struct BlockCoordinateDescentState : public State
+{
+    vector_type x_next;                 // Next point, written by the updates of the blocks
+    std::vector<vector_type> grads;     // Last partial gradient of each block
+    std::vector<scalar_type> residuals; // Last norm of the partial gradient of each block
+    std::vector<scalar_type> steps;     // Last step of each block
+    std::default_random_engine engine;  // Random engine of the selection of the colors
+};
+
+// Parallel block coordinate descent algorithm
+// T is the rule used to select the blocks to update
+template <BlockCoordinateDescentType T>
+class BlockCoordinateDescent : public Method
+{
+
+public:
+    // Constructor with parameters
+    BlockCoordinateDescent(const BlockCoordinateDescentParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<BlockCoordinateDescentState>();
+        const index_type n_blocks = params.blocks.size();
+        state->x = params.initial_condition;
+        state->x_next = state->x;
+        state->grads.resize(n_blocks);
+        state->residuals.assign(n_blocks, std::numeric_limits<scalar_type>::infinity());
+        state->steps.assign(n_blocks, std::numeric_limits<scalar_type>::infinity());
+        state->engine.seed(0);
+        return state;
+    }
+
+    /**
+     * One iteration of the block coordinate descent algorithm (operator()
+     * loops over it until the run stops).
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note Every iteration updates all the blocks of one color at the same
+     * time (one TBB task per block). Blocks with the same color share no term
+     * of f, so each update reads only coordinates that no other task is
+     * writing, and it evaluates only the terms of its own block: the partial
+     * derivatives are computed by centered finite differences of
+     * `block_functions[b]` and the step is chosen with the Armijo rule.
+     *
+     * @note The color is selected cyclically if
+     * `T == BlockCoordinateDescentType::cyclic`, uniformly at random if
+     * `T == BlockCoordinateDescentType::random`, or as the one with the
+     * largest partial gradient (which requires the partial derivatives of all
+     * the blocks) if `T == BlockCoordinateDescentType::gauss_southwell`.
+     *
+     * @note The algorithm stops when the norm of the gradient is less than
+     * `tolerance_r` or when the step size is less than `tolerance_s`, where
+     * every block contributes with the values of its last update.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<BlockCoordinateDescentState &>(base);
+        vector_type &x = state.x;
+        vector_type &x_next = state.x_next;
+        std::vector<vector_type> &grads = state.grads;
+        std::vector<scalar_type> &residuals = state.residuals;
+        std::vector<scalar_type> &steps = state.steps;
+        const index_type n_blocks = params.blocks.size();
+        const index_type n_colors = params.colors.size();
+        std::uniform_int_distribution<index_type> random_color(0, std::max<index_type>(n_colors - 1, 0));
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Select the color
+        index_type color = 0;
+        if constexpr (T == BlockCoordinateDescentType::cyclic)
+        {
+            color = iteration % n_colors;
+        }
+        else if constexpr (T == BlockCoordinateDescentType::random)
+        {
+            color = random_color(state.engine);
+        }
+        else if constexpr (T == BlockCoordinateDescentType::gauss_southwell)
+        {
+            // Partial derivatives of all the blocks
+            tbb::parallel_for(index_type(0), n_blocks, [&](index_type b)
+                              {
+                                  grads[b] = block_gradient(b, x);
+                                  residuals[b] = grads[b].norm(); });
+            scalar_type largest = -1.0;
+            for (index_type c = 0; c < n_colors; ++c)
+            {
+                scalar_type squared_norm = 0.0;
+                for (index_type b : params.colors[c])
+                    squared_norm += residuals[b] * residuals[b];
+                if (squared_norm > largest)
+                {
+                    largest = squared_norm;
+                    color = c;
+                }
+            }
+        }
+        const std::vector<index_type> &selected = params.colors[color];
+
+        // Update all the blocks of the color concurrently
+        tbb::parallel_for(std::size_t(0), selected.size(), [&](std::size_t k)
+                          {
+                              const index_type b = selected[k];
+                              if constexpr (T != BlockCoordinateDescentType::gauss_southwell)
+                              {
+                                  grads[b] = block_gradient(b, x);
+                                  residuals[b] = grads[b].norm();
+                              }
+                              steps[b] = update_block(b, x, grads[b], x_next); });
+        for (index_type b : selected)
+            for (index_type i : params.blocks[b])
+                x(i) = x_next(i);
+
+        // Check for convergence (norm of the gradient)
+        scalar_type residual = 0.0;
+        for (scalar_type r : residuals)
+            residual += r * r;
+        if (std::sqrt(residual) < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+
+        // Check for convergence (step size)
+        scalar_type step_size = 0.0;
+        for (scalar_type s : steps)
+            step_size += s * s;
+        if (std::sqrt(step_size) < params.tolerance_s)
+        {
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    const std::vector<std::vector<index_type>> &get_blocks() const { return params.blocks; }
+    const std::vector<std::vector<index_type>> &get_colors() const { return params.colors; }
+    scalar_type get_h() const { return params.h; }
+    scalar_type get_sigma() const { return params.sigma; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the block selection rule, the number of blocks and
+     * of colors, initial condition, tolerance_r, tolerance_s, initial step,
+     * maximum iterations, minimum step, h and sigma.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the block selection rule at compile time
+        if constexpr (T == BlockCoordinateDescentType::cyclic)
+        {
+            std::cout << "Block selection: cyclic" << std::endl;
+        }
+        else if constexpr (T == BlockCoordinateDescentType::random)
+        {
+            std::cout << "Block selection: random" << std::endl;
+        }
+        else if constexpr (T == BlockCoordinateDescentType::gauss_southwell)
+        {
+            std::cout << "Block selection: Gauss-Southwell" << std::endl;
+        }
+        std::cout << "blocks: " << params.blocks.size() << " (updated concurrently in " << params.colors.size() << " colors)" << std::endl;
+        Method::print();
+        std::cout << "h: " << params.h << std::endl;
+        std::cout << "sigma: " << params.sigma << std::endl;
+    };
+
+private:
+    BlockCoordinateDescentParams params;
+
+    /**
+     * Partial gradient of f with respect to the coordinates of a block.
+     *
+     * @param b The index of the block
+     * @param x The current point
+     * @return The centered finite differences of the terms of block b
+     */
+    vector_type block_gradient(index_type b, const vector_type &x) const
+    {
+        const std::vector<index_type> &block = params.blocks[b];
+        const scalar_function &f_b = params.block_functions[b];
+        vector_type grad(block.size());
+        vector_type z = x;
+        for (std::size_t k = 0; k < block.size(); ++k)
+        {
+            const index_type i = block[k];
+            z(i) = x(i) + params.h;
+            const scalar_type f_forward = f_b(z);
+            z(i) = x(i) - params.h;
+            const scalar_type f_backward = f_b(z);
+            z(i) = x(i);
+            grad(k) = (f_forward - f_backward) / (2 * params.h);
+        }
+        return grad;
+    }
+
+    /**
+     * Gradient step with the Armijo rule on the coordinates of a block.
+     *
+     * @param b The index of the block
+     * @param x The current point (read only)
+     * @param grad The partial gradient of the block at x
+     * @param x_next The next point, only the coordinates of block b are written
+     * @return The length of the step
+     */
+    scalar_type update_block(index_type b, const vector_type &x, const vector_type &grad, vector_type &x_next) const
+    {
+        const std::vector<index_type> &block = params.blocks[b];
+        const scalar_function &f_b = params.block_functions[b];
+        vector_type z = x;
+        const scalar_type f_x = f_b(z);
+
+        // Move the coordinates of the block along the partial gradient
+        auto trial = [&](scalar_type alpha)
+        {
+            for (std::size_t k = 0; k < block.size(); ++k)
+                z(block[k]) = x(block[k]) - alpha * grad(k);
+            return f_b(z);
+        };
+
+        scalar_type alpha = params.initial_step;
+        while (alpha > params.minimum_step && f_x - trial(alpha) < params.sigma * alpha * grad.squaredNorm())
+            alpha *= 0.5;
+
+        for (std::size_t k = 0; k < block.size(); ++k)
+            x_next(block[k]) = x(block[k]) - alpha * grad(k);
+        return alpha * grad.norm();
+    }
+};
+
+// Variants of block coordinate descent in the solver registry (block_coordinate_descent_t)
+inline const bool block_coordinate_descent_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<BlockCoordinateDescent<BlockCoordinateDescentType::cyclic>, BlockCoordinateDescentParams>("block_coordinate_descent", "Cyclic");
+    registry.add<BlockCoordinateDescent<BlockCoordinateDescentType::random>, BlockCoordinateDescentParams>("block_coordinate_descent", "Random");
+    registry.add<BlockCoordinateDescent<BlockCoordinateDescentType::gauss_southwell>, BlockCoordinateDescentParams>("block_coordinate_descent", "Gauss-Southwell");
+    return true;
+}();
+
+#endif // BLOCK_COORDINATE_DESCENT_HPP
@@ -0,0 +1,355 @@
+#ifndef CMA_ES_HPP
+#define CMA_ES_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <algorithm> // For std::sort
+#include <cstdint>
+#include <numeric>   // For std::iota
+#include <random>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Parameters for the CMA-ES algorithm
+struct CMAESParams : public Params
+{
+    CMAESParams() = default;
+    // Constructor for CMAESParams
+    CMAESParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                int_type max_iterations, scalar_type minimum_step,
+                int_type population_size, int_type restarts)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          population_size(population_size > 0 ? std::max<int_type>(population_size, 4) : 0), restarts(restarts) {}
+    int_type population_size; // Number of samples per generation (lambda, at least 4), 0 for 4 + 3 ln(n)
+    int_type restarts;        // Maximum number of restarts (IPOP)
+};
+
+// Restart strategies
+enum class CMAESType
+{
+    standard,
+    ipop
+};
+
+// State of a run of CMA-ES
+struct CMAESState : public State
+{
+    CMAESState(const scalar_function &f) : local_f(f) {}
+    tbb::enumerable_thread_specific<scalar_function> local_f; // Each thread evaluates its own copy of f
+    scalar_type f_best;                                       // Value of f at the best point found (x)
+    int_type restart = 0;                                     // Index of the current run (IPOP)
+    index_type generation = 0;                                // Generations of the current run
+
+    // Strategy parameters of the current run
+    index_type lambda;           // Population size
+    index_type mu;               // Number of selected samples
+    vector_type w;               // Recombination weights
+    scalar_type mu_eff;          // Variance effective selection mass
+    scalar_type c_sigma;         // Learning rate of the step size path
+    scalar_type d_sigma;         // Damping of the step size
+    scalar_type c_c;             // Learning rate of the covariance path
+    scalar_type c_1;             // Learning rate of the rank-one update
+    scalar_type c_mu;            // Learning rate of the rank-mu update
+    scalar_type chi_n;           // Expected norm of a N(0, I) sample
+    index_type eigen_interval;   // Generations between two eigendecompositions of C
+
+    // Distribution of the current run
+    vector_type m;                                   // Mean
+    scalar_type sigma;                               // Step size
+    matrix_type C;                                   // Covariance matrix
+    matrix_type B;                                   // Eigenvectors of C
+    vector_type D;                                   // Square roots of the eigenvalues of C
+    vector_type p_sigma;                             // Evolution path of the step size
+    vector_type p_c;                                 // Evolution path of the covariance matrix
+    Eigen::SelfAdjointEigenSolver<matrix_type> eigen; // Eigendecomposition of C
+
+    // Population
+    matrix_type Z;                 // Samples of N(0, I)
+    matrix_type Y;                 // Steps B D z of the samples
+    vector_type F;                 // Values of f at the samples
+    std::vector<index_type> order; // Samples sorted by value of f
+    matrix_type Y_selected;        // Steps of the selected samples
+};
+
+// Covariance Matrix Adaptation Evolution Strategy
+// T is the restart strategy
+template <CMAESType T>
+class CMAES : public Method
+{
+
+public:
+    // Constructor with parameters
+    CMAES(const CMAESParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: the first run, centered at the initial condition
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<CMAESState>(params.f);
+        const index_type n = params.initial_condition.size();
+        state->x = params.initial_condition;
+        state->f_best = params.f(state->x);
+        state->lambda = params.population_size > 0 ? params.population_size
+                                                   : 4 + static_cast<index_type>(3 * std::log(n));
+        begin(*state);
+        return state;
+    }
+
+    /**
+     * One generation of the CMA-ES algorithm (operator() loops over it until
+     * the run stops). The point of the state is the best point found.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note Every generation samples lambda points \f$ x_k = m + \sigma B D z_k \f$,
+     * with \f$ z_k \sim N(0, I) \f$ and \f$ C = B D^2 B^T \f$, where \f$ \sigma \f$
+     * starts from `initial_step`. Sampling and evaluation are done in parallel:
+     * each sample has its own random engine (seeded with the generation and
+     * its index, so the results do not depend on the scheduling) and each
+     * thread its own copy of f. The mean, the evolution paths, the step size
+     * (cumulative step size adaptation) and C (rank-one and rank-mu updates)
+     * are then updated as in Hansen's tutorial.
+     *
+     * @note The eigendecomposition of C is refreshed lazily, only every
+     * \f$ \lambda / (10 n (c_1 + c_\mu)) \f$ generations (that is O(n)
+     * generations), and B and D are reused in between.
+     *
+     * @note A run stops when the values of f in a generation differ by less
+     * than `tolerance_r` (residual criterion) or when \f$ \sigma \max D \f$ is
+     * less than `tolerance_s` (step size criterion). If
+     * `T == CMAESType::ipop` the algorithm is then restarted from the initial
+     * condition with a doubled population, at most `restarts` times, until
+     * `max_iterations` generations have been used in total. The number of
+     * restarts and the final population size are added to the message of the
+     * stop.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<CMAESState &>(base);
+        if (state.iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            report_restarts(state);
+            return;
+        }
+        ++state.iteration;
+
+        const index_type n = params.initial_condition.size();
+        const index_type lambda = state.lambda;
+        const index_type mu = state.mu;
+        const index_type generation = state.generation;
+        const vector_type &w = state.w;
+        vector_type &m = state.m;
+        scalar_type &sigma = state.sigma;
+        matrix_type &B = state.B;
+        vector_type &D = state.D;
+        vector_type &p_sigma = state.p_sigma;
+        vector_type &p_c = state.p_c;
+        matrix_type &Z = state.Z;
+        matrix_type &Y = state.Y;
+        vector_type &F = state.F;
+        std::vector<index_type> &order = state.order;
+
+        // Sample and evaluate the population
+        tbb::parallel_for(index_type(0), lambda, [&](index_type k)
+                          {
+                              std::mt19937 engine(seed(state.restart, generation, k));
+                              std::normal_distribution<scalar_type> normal;
+                              for (index_type i = 0; i < n; ++i)
+                                  Z(i, k) = normal(engine);
+                              Y.col(k) = B * D.cwiseProduct(Z.col(k));
+                              F(k) = state.local_f.local()(m + sigma * Y.col(k)); });
+
+        // Rank the samples
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](index_type a, index_type b)
+                  { return F(a) < F(b); });
+        if (F(order[0]) < state.f_best)
+        {
+            state.f_best = F(order[0]);
+            state.x = m + sigma * Y.col(order[0]);
+        }
+
+        // Move the mean
+        vector_type y_w = vector_type::Zero(n);
+        vector_type z_w = vector_type::Zero(n);
+        for (index_type i = 0; i < mu; ++i)
+        {
+            state.Y_selected.col(i) = Y.col(order[i]);
+            y_w += w(i) * Y.col(order[i]);
+            z_w += w(i) * Z.col(order[i]);
+        }
+        m += sigma * y_w;
+
+        // Evolution paths (C^(-1/2) y_w = B z_w)
+        const scalar_type c_sigma = state.c_sigma;
+        const scalar_type c_c = state.c_c;
+        p_sigma = (1.0 - c_sigma) * p_sigma + std::sqrt(c_sigma * (2.0 - c_sigma) * state.mu_eff) * (B * z_w);
+        const scalar_type generations = generation + 1.0;
+        const bool h_sigma = p_sigma.norm() / std::sqrt(1.0 - std::pow(1.0 - c_sigma, 2.0 * generations)) < (1.4 + 2.0 / (n + 1.0)) * state.chi_n;
+        p_c = (1.0 - c_c) * p_c + (h_sigma ? std::sqrt(c_c * (2.0 - c_c) * state.mu_eff) : 0.0) * y_w;
+
+        // Covariance matrix (rank-one and rank-mu updates)
+        const scalar_type correction = h_sigma ? 0.0 : c_c * (2.0 - c_c);
+        state.C = (1.0 - state.c_1 - state.c_mu + state.c_1 * correction) * state.C + state.c_1 * p_c * p_c.transpose() +
+                  state.c_mu * state.Y_selected * w.asDiagonal() * state.Y_selected.transpose();
+
+        // Step size
+        sigma *= std::exp((c_sigma / state.d_sigma) * (p_sigma.norm() / state.chi_n - 1.0));
+
+        // Refresh the eigendecomposition of C
+        if ((generation + 1) % state.eigen_interval == 0)
+        {
+            state.eigen.compute(state.C);
+            B = state.eigen.eigenvectors();
+            D = state.eigen.eigenvalues().cwiseMax(0.0).cwiseSqrt();
+        }
+        ++state.generation;
+
+        // Check for convergence (values of f in the generation, then step size)
+        string_type criterion;
+        if (F(order[lambda - 1]) - F(order[0]) < params.tolerance_r)
+            criterion = "residual";
+        else if (sigma * D.maxCoeff() < params.tolerance_s)
+            criterion = "step size";
+        else
+            return;
+
+        if constexpr (T == CMAESType::ipop)
+        {
+            // Restart from the initial condition with a doubled population
+            if (state.restart < params.restarts && state.iteration < params.max_iterations)
+            {
+                ++state.restart;
+                state.lambda *= 2;
+                begin(state);
+                return;
+            }
+        }
+        state.converged(criterion);
+        report_restarts(state);
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    int_type get_population_size() const { return params.population_size; }
+    int_type get_restarts() const { return params.restarts; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the restart strategy, initial condition (initial
+     * mean), tolerance_r, tolerance_s, initial step (initial sigma), maximum
+     * iterations (generations), minimum step, population size and restarts.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the restart strategy at compile time
+        if constexpr (T == CMAESType::standard)
+        {
+            std::cout << "Restart strategy: none" << std::endl;
+        }
+        else if constexpr (T == CMAESType::ipop)
+        {
+            std::cout << "Restart strategy: IPOP (population doubled at every restart)" << std::endl;
+        }
+        Method::print();
+        std::cout << "population_size: " << params.population_size << std::endl;
+        std::cout << "restarts: " << params.restarts << std::endl;
+    };
+
+private:
+    CMAESParams params;
+
+    /**
+     * Start a run of CMA-ES from the initial condition: the strategy
+     * parameters for the population size of the state, the distribution and
+     * the population.
+     *
+     * @param state The state of the run
+     */
+    void begin(CMAESState &state) const
+    {
+        const index_type n = params.initial_condition.size();
+        const index_type lambda = state.lambda;
+        const index_type mu = lambda / 2;
+        state.mu = mu;
+        state.generation = 0;
+
+        // Recombination weights
+        vector_type &w = state.w;
+        w.resize(mu);
+        for (index_type i = 0; i < mu; ++i)
+            w(i) = std::log(mu + 0.5) - std::log(i + 1.0);
+        w /= w.sum();
+        const scalar_type mu_eff = 1.0 / w.squaredNorm();
+        state.mu_eff = mu_eff;
+
+        // Learning rates
+        state.c_sigma = (mu_eff + 2.0) / (n + mu_eff + 5.0);
+        state.d_sigma = 1.0 + 2.0 * std::max(0.0, std::sqrt((mu_eff - 1.0) / (n + 1.0)) - 1.0) + state.c_sigma;
+        state.c_c = (4.0 + mu_eff / n) / (n + 4.0 + 2.0 * mu_eff / n);
+        state.c_1 = 2.0 / ((n + 1.3) * (n + 1.3) + mu_eff);
+        state.c_mu = std::min(1.0 - state.c_1, 2.0 * (mu_eff - 2.0 + 1.0 / mu_eff) / ((n + 2.0) * (n + 2.0) + mu_eff));
+        state.chi_n = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+        state.eigen_interval = std::max<index_type>(1, lambda / (10.0 * n * (state.c_1 + state.c_mu)));
+
+        // Distribution
+        state.m = params.initial_condition;
+        state.sigma = params.initial_step;
+        state.C = matrix_type::Identity(n, n);
+        state.B = matrix_type::Identity(n, n);
+        state.D = vector_type::Ones(n);
+        state.p_sigma = vector_type::Zero(n);
+        state.p_c = vector_type::Zero(n);
+        state.eigen = Eigen::SelfAdjointEigenSolver<matrix_type>(n);
+
+        // Population
+        state.Z.resize(n, lambda);
+        state.Y.resize(n, lambda);
+        state.F.resize(lambda);
+        state.order.resize(lambda);
+        state.Y_selected.resize(n, mu);
+    }
+
+    /**
+     * Add the restarts of the run to the message of the stop (IPOP only).
+     *
+     * @param state The state of the run
+     */
+    void report_restarts(CMAESState &state) const
+    {
+        if constexpr (T == CMAESType::ipop)
+            state.message += " Restarts: " + std::to_string(state.restart) +
+                             " (population_size = " + std::to_string(state.lambda) + ")";
+    }
+
+    /**
+     * Seed of the random engine of a sample.
+     *
+     * @param restart The index of the run
+     * @param generation The generation
+     * @param k The index of the sample
+     * @return A seed that depends only on the arguments
+     */
+    static std::uint32_t seed(int_type restart, index_type generation, index_type k)
+    {
+        std::uint64_t h = (static_cast<std::uint64_t>(restart) << 48) ^ (static_cast<std::uint64_t>(generation) << 20) ^ static_cast<std::uint64_t>(k);
+        // SplitMix64 finalizer
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return static_cast<std::uint32_t>(h ^ (h >> 31));
+    }
+};
+
+// Variants of CMA-ES in the solver registry (cma_es_t)
+inline const bool cma_es_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<CMAES<CMAESType::standard>, CMAESParams>("cma_es", "Standard");
+    registry.add<CMAES<CMAESType::ipop>, CMAESParams>("cma_es", "IPOP");
+    return true;
+}();
+
+#endif // CMA_ES_HPP
@@ -0,0 +1,361 @@
+#ifndef DIFFERENTIAL_EVOLUTION_HPP
+#define DIFFERENTIAL_EVOLUTION_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <atomic>
+#include <memory> // For std::unique_ptr
+#include <random>
+#include <tbb/parallel_for.h>
+
+// Parameters for the differential evolution algorithm
+struct DifferentialEvolutionParams : public Params
+{
+    DifferentialEvolutionParams() = default;
+    // Constructor for DifferentialEvolutionParams
+    DifferentialEvolutionParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                                scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                                int_type max_iterations, scalar_type minimum_step,
+                                vector_type lower_bounds, vector_type upper_bounds,
+                                int_type population_size, int_type islands,
+                                scalar_type differential_weight, scalar_type crossover_rate,
+                                int_type migration_interval)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          lower_bounds(lower_bounds), upper_bounds(upper_bounds), population_size(population_size),
+          islands(islands), differential_weight(differential_weight), crossover_rate(crossover_rate),
+          migration_interval(migration_interval) {}
+    vector_type lower_bounds;        // Lower corner of the box
+    vector_type upper_bounds;        // Upper corner of the box
+    int_type population_size;        // Number of members of each island, 0 for 10 n
+    int_type islands;                // Number of islands
+    scalar_type differential_weight; // Scale F of the difference vectors
+    scalar_type crossover_rate;      // Probability CR of taking a component from the mutant
+    int_type migration_interval;     // Generations between two migrations
+};
+
+// Mutation strategies
+enum class DifferentialEvolutionType
+{
+    rand_1_bin,
+    current_to_best_1_bin
+};
+
+// A member sent to another island
+struct Migrant
+{
+    vector_type x;
+    scalar_type value;
+};
+
+// Population of an island of differential evolution
+struct DifferentialEvolutionIsland
+{
+    scalar_function f;        // Copy of f owned by the island
+    std::mt19937 engine;      // Random engine of the island
+    matrix_type population;   // Members (columns)
+    vector_type values;       // Values of f at the members
+    index_type best = 0;      // Best member
+    index_type iteration = 0; // Number of generations
+    int_type criterion = -1;  // -1 running, 1 residual, 2 step size, 0 not converged
+};
+
+// State of a run of differential evolution
+struct DifferentialEvolutionState : public State
+{
+    DifferentialEvolutionState(index_type islands) : islands(islands), mailboxes(islands)
+    {
+        for (auto &mailbox : mailboxes)
+            mailbox.store(nullptr);
+    }
+    ~DifferentialEvolutionState()
+    {
+        // Free the migrants that have not been collected
+        for (auto &mailbox : mailboxes)
+            delete mailbox.exchange(nullptr);
+    }
+    std::vector<DifferentialEvolutionIsland> islands; // Islands of the ring
+    std::vector<std::atomic<Migrant *>> mailboxes;    // Mailboxes of the islands
+};
+
+// Parallel differential evolution algorithm with an island model
+// T is the mutation strategy
+template <DifferentialEvolutionType T>
+class DifferentialEvolution : public Method
+{
+
+public:
+    // Constructor with parameters
+    DifferentialEvolution(const DifferentialEvolutionParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: random populations in the box (the initial condition is a member of the first island)
+    std::unique_ptr<State> start() const override
+    {
+        const index_type islands = std::max<int_type>(params.islands, 1);
+        auto state = std::make_unique<DifferentialEvolutionState>(islands);
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const index_type n = lower.size();
+        const index_type size = params.population_size > 0 ? std::max<int_type>(params.population_size, 4) : 10 * n;
+        tbb::parallel_for(index_type(0), islands, [&](index_type i)
+                          {
+                              DifferentialEvolutionIsland &island = state->islands[i];
+                              island.f = params.f;
+                              island.engine.seed(i);
+                              std::uniform_real_distribution<scalar_type> uniform(0.0, 1.0);
+                              island.population.resize(n, size);
+                              island.values.resize(size);
+                              for (index_type k = 0; k < size; ++k)
+                              {
+                                  for (index_type j = 0; j < n; ++j)
+                                      island.population(j, k) = lower(j) + uniform(island.engine) * (upper(j) - lower(j));
+                                  if (i == 0 && k == 0)
+                                      island.population.col(k) = params.initial_condition.cwiseMax(lower).cwiseMin(upper);
+                                  island.values(k) = island.f(island.population.col(k));
+                              }
+                              island.values.minCoeff(&island.best);
+                              if (params.max_iterations <= 0)
+                                  island.criterion = 0; }, tbb::simple_partitioner());
+        const DifferentialEvolutionIsland &best = state->islands[best_island(*state)];
+        state->x = best.population.col(best.best);
+        return state;
+    }
+
+    /**
+     * One epoch of the differential evolution algorithm (operator() loops
+     * over it until the run stops). The point of the state is the best member
+     * of all the islands.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The islands evolve independently, each one in its own TBB task
+     * with its own copy of f, its own random engine and its population stored
+     * in a contiguous matrix (one column per member). In a step every island
+     * that has not stopped runs its own loop of generations, without waiting
+     * for the others, until its next migration (`migration_interval`
+     * generations, or until it stops if there are no migrations), so the
+     * islands only meet at the end of the step.
+     *
+     * @note For every member x_i a mutant is built as
+     * \f$ v = x_{r_1} + F (x_{r_2} - x_{r_3}) \f$ if
+     * `T == DifferentialEvolutionType::rand_1_bin`, or as
+     * \f$ v = x_i + F (x_{best} - x_i) + F (x_{r_1} - x_{r_2}) \f$ if
+     * `T == DifferentialEvolutionType::current_to_best_1_bin`; every
+     * component is taken from v with probability CR (binomial crossover) and
+     * the trial point replaces x_i if it is not worse.
+     *
+     * @note The islands form a ring: every `migration_interval` generations
+     * an island posts a copy of its best member in the mailbox of the next
+     * island (an atomic pointer, so posting and collecting never block) and
+     * collects the migrant posted by the previous one, which replaces its
+     * worst member if it is better. A migrant that has not been collected yet
+     * is simply overwritten by the next one.
+     *
+     * @note An island stops when the values of f of its members differ by
+     * less than `tolerance_r` (residual criterion), when all its members are
+     * closer than `tolerance_s` to its best one (step size criterion) or after
+     * `max_iterations` generations. The stopping criterion reported is the one
+     * of the island that found the best point.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<DifferentialEvolutionState &>(base);
+        const index_type islands = state.islands.size();
+
+        // Evolve the islands concurrently, each one up to its next migration
+        tbb::parallel_for(index_type(0), islands, [&](index_type i)
+                          {
+                              DifferentialEvolutionIsland &island = state.islands[i];
+                              while (island.criterion < 0)
+                              {
+                                  evolve(island, state.mailboxes[i], state.mailboxes[(i + 1) % islands]);
+                                  if (params.migration_interval > 0 && island.iteration % params.migration_interval == 0)
+                                      break;
+                              } }, tbb::simple_partitioner());
+
+        // Best island
+        const DifferentialEvolutionIsland &best = state.islands[best_island(state)];
+        state.x = best.population.col(best.best);
+        state.iteration = 0;
+        for (const DifferentialEvolutionIsland &island : state.islands)
+            state.iteration = std::max(state.iteration, island.iteration);
+        for (const DifferentialEvolutionIsland &island : state.islands)
+            if (island.criterion < 0)
+                return;
+        state.iteration = best.iteration;
+        if (best.criterion == 1)
+            state.converged("residual");
+        else if (best.criterion == 2)
+            state.converged("step size");
+        else
+            state.not_converged();
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_type get_lower_bounds() const { return params.lower_bounds; }
+    vector_type get_upper_bounds() const { return params.upper_bounds; }
+    int_type get_population_size() const { return params.population_size; }
+    int_type get_islands() const { return params.islands; }
+    scalar_type get_differential_weight() const { return params.differential_weight; }
+    scalar_type get_crossover_rate() const { return params.crossover_rate; }
+    int_type get_migration_interval() const { return params.migration_interval; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the mutation strategy, the box, initial condition
+     * (a member of the first island), tolerance_r, tolerance_s, initial step,
+     * maximum iterations (generations), minimum step, population size,
+     * islands, differential weight, crossover rate and migration interval.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the mutation strategy at compile time
+        if constexpr (T == DifferentialEvolutionType::rand_1_bin)
+        {
+            std::cout << "Mutation strategy: rand/1/bin" << std::endl;
+        }
+        else if constexpr (T == DifferentialEvolutionType::current_to_best_1_bin)
+        {
+            std::cout << "Mutation strategy: current-to-best/1/bin" << std::endl;
+        }
+        Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+        std::cout << "lower_bounds: " << params.lower_bounds.format(commaFormat) << std::endl;
+        std::cout << "upper_bounds: " << params.upper_bounds.format(commaFormat) << std::endl;
+        Method::print();
+        std::cout << "population_size: " << params.population_size << std::endl;
+        std::cout << "islands: " << params.islands << std::endl;
+        std::cout << "differential_weight: " << params.differential_weight << std::endl;
+        std::cout << "crossover_rate: " << params.crossover_rate << std::endl;
+        std::cout << "migration_interval: " << params.migration_interval << std::endl;
+    };
+
+private:
+    DifferentialEvolutionParams params;
+
+    // DifferentialEvolutionIsland with the best member
+    static index_type best_island(const DifferentialEvolutionState &state)
+    {
+        index_type best = 0;
+        for (std::size_t island = 1; island < state.islands.size(); ++island)
+            if (state.islands[island].values(state.islands[island].best) < state.islands[best].values(state.islands[best].best))
+                best = island;
+        return best;
+    }
+
+    /**
+     * Evolve an island by one generation.
+     *
+     * @param island The island
+     * @param inbox The mailbox of the island
+     * @param outbox The mailbox of the next island of the ring
+     */
+    void evolve(DifferentialEvolutionIsland &island, std::atomic<Migrant *> &inbox, std::atomic<Migrant *> &outbox) const
+    {
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const index_type n = lower.size();
+        matrix_type &population = island.population;
+        vector_type &values = island.values;
+        index_type &best = island.best;
+        std::mt19937 &engine = island.engine;
+        const index_type size = population.cols();
+        std::uniform_real_distribution<scalar_type> uniform(0.0, 1.0);
+        std::uniform_int_distribution<index_type> member(0, size - 1);
+        std::uniform_int_distribution<index_type> component(0, n - 1);
+        vector_type trial(n);
+
+        for (index_type i = 0; i < size; ++i)
+        {
+            // Distinct random members, all different from i
+            index_type r[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                do
+                    r[k] = member(engine);
+                while (r[k] == i || (k > 0 && r[k] == r[0]) || (k > 1 && r[k] == r[1]));
+            }
+
+            // Mutation and binomial crossover
+            const index_type forced = component(engine);
+            for (index_type j = 0; j < n; ++j)
+            {
+                if (j != forced && uniform(engine) >= params.crossover_rate)
+                {
+                    trial(j) = population(j, i);
+                    continue;
+                }
+                scalar_type v;
+                if constexpr (T == DifferentialEvolutionType::rand_1_bin)
+                    v = population(j, r[0]) + params.differential_weight * (population(j, r[1]) - population(j, r[2]));
+                else
+                    v = population(j, i) + params.differential_weight * (population(j, best) - population(j, i) + population(j, r[0]) - population(j, r[1]));
+                // Components outside of the box are moved halfway between the parent and the bound
+                if (v < lower(j))
+                    v = 0.5 * (population(j, i) + lower(j));
+                else if (v > upper(j))
+                    v = 0.5 * (population(j, i) + upper(j));
+                trial(j) = v;
+            }
+
+            // Selection
+            const scalar_type value = island.f(trial);
+            if (value <= values(i))
+            {
+                population.col(i) = trial;
+                values(i) = value;
+                if (value < values(best))
+                    best = i;
+            }
+        }
+
+        // Migration along the ring
+        if (params.migration_interval > 0 && (island.iteration + 1) % params.migration_interval == 0)
+        {
+            delete outbox.exchange(new Migrant{population.col(best), values(best)});
+            std::unique_ptr<Migrant> migrant(inbox.exchange(nullptr));
+            if (migrant)
+            {
+                index_type worst;
+                values.maxCoeff(&worst);
+                if (migrant->value < values(worst) && worst != best)
+                {
+                    population.col(worst) = migrant->x;
+                    values(worst) = migrant->value;
+                    if (migrant->value < values(best))
+                        best = worst;
+                }
+            }
+        }
+
+        // Check for convergence (values of f of the members)
+        if (values.maxCoeff() - values(best) < params.tolerance_r)
+        {
+            island.criterion = 1;
+            return;
+        }
+
+        // Check for convergence (distance of the members from the best one)
+        if ((population.colwise() - population.col(best)).colwise().norm().maxCoeff() < params.tolerance_s)
+        {
+            island.criterion = 2;
+            return;
+        }
+
+        // Check for the maximum number of generations
+        if (++island.iteration == params.max_iterations)
+            island.criterion = 0;
+    }
+};
+
+// Variants of differential evolution in the solver registry (differential_evolution_t)
+inline const bool differential_evolution_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<DifferentialEvolution<DifferentialEvolutionType::rand_1_bin>, DifferentialEvolutionParams>("differential_evolution", "rand/1/bin");
+    registry.add<DifferentialEvolution<DifferentialEvolutionType::current_to_best_1_bin>, DifferentialEvolutionParams>("differential_evolution", "current-to-best/1/bin");
+    return true;
+}();
+
+#endif // DIFFERENTIAL_EVOLUTION_HPP
@@ -0,0 +1,439 @@
+#ifndef DIRECT_HPP
+#define DIRECT_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <algorithm> // For std::push_heap, std::pop_heap
+#include <numeric>   // For std::accumulate
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Parameters for the DIRECT algorithm
+struct DirectParams : public Params
+{
+    DirectParams() = default;
+    // Constructor for DirectParams
+    DirectParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                 scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                 int_type max_iterations, scalar_type minimum_step,
+                 vector_type lower_bounds, vector_type upper_bounds, scalar_type epsilon)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          lower_bounds(lower_bounds), upper_bounds(upper_bounds), epsilon(epsilon) {}
+    vector_type lower_bounds; // Lower corner of the box
+    vector_type upper_bounds; // Upper corner of the box
+    scalar_type epsilon;      // Minimum relative improvement of a potentially optimal rectangle
+};
+
+/**
+ * \brief Hyperrectangles of the DIRECT algorithm, bucketed by size
+ *
+ * The box is mapped to the unit hypercube and every rectangle is stored as
+ * its center, the value of f at the center and the number of times each side
+ * has been trisected. Since only the longest sides are divided, the sides of
+ * a rectangle are 3^-k or 3^-(k+1) long, so its size depends only on its
+ * level (the total number of trisections). Each level is a bucket, kept as a
+ * binary heap on the values of f, so the best rectangle of every size is
+ * available in constant time and the selection of the potentially optimal
+ * rectangles only scans the levels, not the rectangles.
+ *
+ * The data of the rectangles are stored in flat arrays, without any
+ * allocation per rectangle.
+ */
+class RectangleBuckets
+{
+public:
+    //! Constructor with the dimension of the problem
+    RectangleBuckets(index_type n) : n(n) {}
+
+    //! Number of rectangles
+    index_type size() const { return values.size(); }
+
+    //! Add k rectangles (not in any bucket yet) and return the index of the first one
+    index_type allocate(index_type k)
+    {
+        const index_type first = size();
+        centers.resize((first + k) * n);
+        trisections.resize((first + k) * n);
+        values.resize(first + k);
+        return first;
+    }
+
+    //! Center of a rectangle (in the unit hypercube)
+    Eigen::Map<vector_type> center(index_type r) { return {centers.data() + r * n, n}; }
+    Eigen::Map<const vector_type> center(index_type r) const { return {centers.data() + r * n, n}; }
+
+    //! Number of trisections of each side of a rectangle
+    int_type *sides(index_type r) { return trisections.data() + r * n; }
+    const int_type *sides(index_type r) const { return trisections.data() + r * n; }
+
+    //! Value of f at the center of a rectangle
+    scalar_type &value(index_type r) { return values[r]; }
+    scalar_type value(index_type r) const { return values[r]; }
+
+    //! Total number of trisections of a rectangle
+    index_type level(index_type r) const
+    {
+        const int_type *k = sides(r);
+        return std::accumulate(k, k + n, index_type(0));
+    }
+
+    //! Distance from the center to the vertices of the rectangles of a level (in the unit hypercube)
+    scalar_type half_diagonal(index_type l) const
+    {
+        const index_type k = l / n, shorter = l % n;
+        return 0.5 * std::sqrt((n - shorter) * std::pow(9.0, -k) + shorter * std::pow(9.0, -(k + 1)));
+    }
+
+    //! Number of levels (some buckets can be empty)
+    index_type levels() const { return buckets.size(); }
+
+    //! True if there are no rectangles of level l
+    bool empty(index_type l) const { return buckets[l].empty(); }
+
+    //! Rectangle of level l with the lowest value of f
+    index_type top(index_type l) const { return buckets[l].front(); }
+
+    //! Insert a rectangle in the bucket of its level
+    void push(index_type r)
+    {
+        const index_type l = level(r);
+        if (l >= levels())
+            buckets.resize(l + 1);
+        buckets[l].push_back(r);
+        std::push_heap(buckets[l].begin(), buckets[l].end(), Greater{values});
+    }
+
+    //! Remove the rectangle with the lowest value of f from the bucket of level l
+    void pop(index_type l)
+    {
+        std::pop_heap(buckets[l].begin(), buckets[l].end(), Greater{values});
+        buckets[l].pop_back();
+    }
+
+private:
+    // Comparison of the values at the centers (min heap)
+    struct Greater
+    {
+        const std::vector<scalar_type> &values;
+        bool operator()(index_type a, index_type b) const { return values[a] > values[b]; }
+    };
+
+    index_type n;                                // Dimension of the problem
+    std::vector<scalar_type> centers;            // Centers, n values per rectangle
+    std::vector<int_type> trisections;           // Trisections of the sides, n values per rectangle
+    std::vector<scalar_type> values;             // Values of f at the centers
+    std::vector<std::vector<index_type>> buckets; // Heaps of the rectangles of each level
+};
+
+// State of a run of the DIRECT algorithm
+struct DirectState : public State
+{
+    DirectState(index_type n, const scalar_function &f) : rectangles(n), local_f(f) {}
+    RectangleBuckets rectangles;                              // Rectangles, bucketed by size
+    tbb::enumerable_thread_specific<scalar_function> local_f; // Each thread evaluates its own copy of f
+    index_type best = 0;                                      // Rectangle with the best point
+    std::vector<index_type> selected;                         // Potentially optimal rectangles of the iteration
+    std::vector<index_type> first_child;                      // Slots of the children of the selected rectangles
+};
+
+// DIRECT (DIviding RECTangles) global optimization algorithm
+class Direct : public Method
+{
+
+public:
+    // Constructor with parameters
+    Direct(const DirectParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: the first rectangle is the whole box
+    std::unique_ptr<State> start() const override
+    {
+        const index_type n = params.lower_bounds.size();
+        auto state = std::make_unique<DirectState>(n, params.f);
+        RectangleBuckets &rectangles = state->rectangles;
+        rectangles.allocate(1);
+        rectangles.center(0).setConstant(0.5);
+        std::fill(rectangles.sides(0), rectangles.sides(0) + n, 0);
+        rectangles.value(0) = evaluate(*state, rectangles.center(0));
+        rectangles.push(0);
+        state->x = point(rectangles.center(0));
+        return state;
+    }
+
+    /**
+     * One iteration of the DIRECT algorithm (operator() loops over it until
+     * the run stops). The point of the state is the best point found in the
+     * box.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note Every iteration selects the potentially optimal rectangles: the
+     * rectangles with the lowest value of f among the ones of the same size
+     * that lie on the lower right convex hull of the points (d, f), where d
+     * is the half diagonal, and that can improve the best value by at least
+     * `epsilon` times its absolute value for some Lipschitz constant.
+     *
+     * @note Every selected rectangle is sampled at c +- delta e_i along its
+     * longest sides (delta is one third of their length) and then trisected
+     * along them, starting from the side with the best sample. The samples
+     * of all the selected rectangles are evaluated together in parallel (each
+     * thread with its own copy of f) and the rectangles are divided in
+     * parallel too, since their children are stored in disjoint slots.
+     *
+     * @note The algorithm stops after `max_iterations` iterations or when
+     * the half diagonal of the rectangle with the best point is less than
+     * `tolerance_s`; f is never differentiated, so `tolerance_r` is not used.
+     * It also stops, without convergence, if no rectangle is potentially
+     * optimal.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<DirectState &>(base);
+        RectangleBuckets &rectangles = state.rectangles;
+        std::vector<index_type> &selected = state.selected;
+        std::vector<index_type> &first_child = state.first_child;
+        index_type &best = state.best;
+        const vector_type width = params.upper_bounds - params.lower_bounds;
+        const index_type n = width.size();
+        if (state.iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            state.message += "\nRectangles: " + std::to_string(rectangles.size());
+            return;
+        }
+
+        // Check for convergence (size of the rectangle with the best point)
+        const int_type *k_best = rectangles.sides(best);
+        scalar_type step_size = 0.0;
+        for (index_type i = 0; i < n; ++i)
+            step_size += std::pow(width(i) * std::pow(3.0, -k_best[i]), 2);
+        if (0.5 * std::sqrt(step_size) < params.tolerance_s)
+        {
+            state.converged("step size");
+            state.message += "\nRectangles: " + std::to_string(rectangles.size());
+            return;
+        }
+
+        // Select the potentially optimal rectangles and remove them from their buckets
+        select(rectangles, rectangles.value(best), selected);
+        if (selected.empty())
+        {
+            state.stop("Stopped: no potentially optimal rectangle after " + std::to_string(state.iteration) + " iterations");
+            state.message += "\nRectangles: " + std::to_string(rectangles.size());
+            return;
+        }
+        for (index_type r : selected)
+            rectangles.pop(rectangles.level(r));
+
+        // Slots of the children: two for each longest side of each selected rectangle
+        first_child.resize(selected.size() + 1);
+        first_child[0] = rectangles.size();
+        for (std::size_t j = 0; j < selected.size(); ++j)
+        {
+            const int_type *k = rectangles.sides(selected[j]);
+            const int_type k_min = *std::min_element(k, k + n);
+            first_child[j + 1] = first_child[j] + 2 * std::count(k, k + n, k_min);
+        }
+        rectangles.allocate(first_child.back() - first_child.front());
+
+        // Sample the children (all the rectangles together)
+        tbb::parallel_for(std::size_t(0), selected.size(), [&](std::size_t j)
+                          { sample(rectangles, selected[j], first_child[j]); });
+        tbb::parallel_for(first_child.front(), first_child.back(), [&](index_type c)
+                          { rectangles.value(c) = evaluate(state, rectangles.center(c)); });
+
+        // Divide the rectangles
+        tbb::parallel_for(std::size_t(0), selected.size(), [&](std::size_t j)
+                          { divide(rectangles, selected[j], first_child[j]); });
+        for (index_type r : selected)
+            rectangles.push(r);
+        for (index_type c = first_child.front(); c < first_child.back(); ++c)
+        {
+            rectangles.push(c);
+            if (rectangles.value(c) < rectangles.value(best))
+                best = c;
+        }
+        state.x = point(rectangles.center(best));
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_type get_lower_bounds() const { return params.lower_bounds; }
+    vector_type get_upper_bounds() const { return params.upper_bounds; }
+    scalar_type get_epsilon() const { return params.epsilon; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the box, initial condition (not used),
+     * tolerance_r, tolerance_s, initial step, maximum iterations, minimum
+     * step and epsilon.
+     */
+    void print() const override
+    {
+        Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+        std::cout << "lower_bounds: " << params.lower_bounds.format(commaFormat) << std::endl;
+        std::cout << "upper_bounds: " << params.upper_bounds.format(commaFormat) << std::endl;
+        Method::print();
+        std::cout << "epsilon: " << params.epsilon << std::endl;
+    };
+
+private:
+    DirectParams params;
+
+    // Point of the box that corresponds to a point of the unit hypercube
+    vector_type point(const Eigen::Ref<const vector_type> &c) const
+    {
+        return params.lower_bounds + (params.upper_bounds - params.lower_bounds).cwiseProduct(c);
+    }
+
+    // Value of f at a point of the unit hypercube (with the copy of f of the calling thread)
+    scalar_type evaluate(DirectState &state, const Eigen::Ref<const vector_type> &c) const
+    {
+        return state.local_f.local()(point(c));
+    }
+
+    // Rectangles with more trisections than this on a side are not divided (3^-30 ~ 5e-15)
+    static constexpr int_type max_trisections = 30;
+
+    /**
+     * Potentially optimal rectangles.
+     *
+     * The best rectangle of every level is a candidate. The candidates on
+     * the lower right convex hull of the points (d, f) are kept if, with the
+     * largest Lipschitz constant K for which they are on the hull, they
+     * satisfy f - K d <= f_min - epsilon |f_min|.
+     *
+     * @param rectangles The rectangles
+     * @param f_min The best value of f
+     * @param selected The selected rectangles
+     */
+    void select(const RectangleBuckets &rectangles, scalar_type f_min, std::vector<index_type> &selected) const
+    {
+        const index_type n = params.lower_bounds.size();
+        selected.clear();
+
+        // Candidates, from the largest level (smallest rectangles) to the smallest one
+        std::vector<index_type> candidates;
+        for (index_type l = std::min(rectangles.levels(), n * max_trisections) - 1; l >= 0; --l)
+            if (!rectangles.empty(l))
+                candidates.push_back(rectangles.top(l));
+        if (candidates.empty())
+            return;
+        auto d = [&](index_type r)
+        { return rectangles.half_diagonal(rectangles.level(r)); };
+        auto f = [&](index_type r)
+        { return rectangles.value(r); };
+
+        // Start from the candidate with the lowest value (the largest one if tied)
+        std::size_t start = 0;
+        for (std::size_t j = 1; j < candidates.size(); ++j)
+            if (f(candidates[j]) <= f(candidates[start]))
+                start = j;
+
+        // Lower right convex hull (monotone chain, d increasing)
+        std::vector<index_type> hull;
+        for (std::size_t j = start; j < candidates.size(); ++j)
+        {
+            const index_type c = candidates[j];
+            while (hull.size() >= 2)
+            {
+                const index_type a = hull[hull.size() - 2], b = hull.back();
+                const scalar_type cross = (d(b) - d(a)) * (f(c) - f(a)) - (f(b) - f(a)) * (d(c) - d(a));
+                if (cross > 0.0)
+                    break;
+                hull.pop_back();
+            }
+            hull.push_back(c);
+        }
+
+        // Sufficient improvement
+        const scalar_type target = f_min - params.epsilon * std::abs(f_min);
+        for (std::size_t j = 0; j < hull.size(); ++j)
+        {
+            if (j + 1 == hull.size())
+            {
+                selected.push_back(hull[j]);
+                continue;
+            }
+            const index_type a = hull[j], b = hull[j + 1];
+            const scalar_type K = (f(b) - f(a)) / (d(b) - d(a));
+            if (f(a) - K * d(a) <= target)
+                selected.push_back(a);
+        }
+    }
+
+    /**
+     * Centers of the children of a rectangle: c +- delta e_i for every
+     * longest side i, where delta is one third of the side.
+     *
+     * @param rectangles The rectangles
+     * @param r The rectangle to be divided
+     * @param first The slot of the first child
+     */
+    void sample(RectangleBuckets &rectangles, index_type r, index_type first) const
+    {
+        const index_type n = params.lower_bounds.size();
+        const int_type *k = rectangles.sides(r);
+        const int_type k_min = *std::min_element(k, k + n);
+        const scalar_type delta = std::pow(3.0, -(k_min + 1));
+        index_type c = first;
+        for (index_type i = 0; i < n; ++i)
+        {
+            if (k[i] != k_min)
+                continue;
+            rectangles.center(c) = rectangles.center(r);
+            rectangles.center(c)(i) += delta;
+            rectangles.center(c + 1) = rectangles.center(r);
+            rectangles.center(c + 1)(i) -= delta;
+            c += 2;
+        }
+    }
+
+    /**
+     * Trisect a rectangle along its longest sides, starting from the side
+     * whose best child has the lowest value, so that the best children get
+     * the largest rectangles.
+     *
+     * @param rectangles The rectangles
+     * @param r The rectangle to be divided (it becomes the central one)
+     * @param first The slot of the first child
+     */
+    void divide(RectangleBuckets &rectangles, index_type r, index_type first) const
+    {
+        const index_type n = params.lower_bounds.size();
+        int_type *k = rectangles.sides(r);
+        const int_type k_min = *std::min_element(k, k + n);
+
+        // Longest sides and their pairs of children
+        std::vector<std::pair<index_type, index_type>> order; // (side, first child of the pair)
+        for (index_type i = 0, c = first; i < n; ++i)
+            if (k[i] == k_min)
+            {
+                order.emplace_back(i, c);
+                c += 2;
+            }
+        std::sort(order.begin(), order.end(), [&](const auto &a, const auto &b)
+                  { return std::min(rectangles.value(a.second), rectangles.value(a.second + 1)) <
+                           std::min(rectangles.value(b.second), rectangles.value(b.second + 1)); });
+
+        // Every pair of children gets the sides of the central rectangle after the previous trisections
+        for (const auto &[i, c] : order)
+        {
+            ++k[i];
+            std::copy(k, k + n, rectangles.sides(c));
+            std::copy(k, k + n, rectangles.sides(c + 1));
+        }
+    }
+};
+
+// DIRECT in the solver registry (there is only one variant)
+inline const bool direct_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<Direct, DirectParams>("direct");
+    return true;
+}();
+
+#endif // DIRECT_HPP
@@ -2,6 +2,8 @@
 #define GRADIENT_DESCENT_HPP
 
 #include "method.hpp"
+#include "registry.hpp"
+#include "preconditioner.hpp"
 
 // Parameters for the gradient descent algorithm
 struct GradientDescentParams : public Params
@@ -11,12 +13,17 @@ struct GradientDescentParams : public Params
     GradientDescentParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
                           scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
                           int_type max_iterations, scalar_type minimum_step,
-                          scalar_type sigma, scalar_type mu)
+                          scalar_type sigma, scalar_type mu, Box box = Box(),
+                          Preconditioner preconditioner = Preconditioner(),
+                          StepAdaptation adaptation = StepAdaptation())
         : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
                  initial_step, max_iterations, minimum_step),
-          sigma(sigma), mu(mu) {}
-    scalar_type sigma; // Parameter for the Armijo rule
-    scalar_type mu;    // Parameter for the exponential decay and the inverse decay
+          sigma(sigma), mu(mu), box(box), preconditioner(preconditioner), adaptation(adaptation) {}
+    scalar_type sigma;             // Parameter for the Armijo rule
+    scalar_type mu;                // Parameter for the exponential decay and the inverse decay
+    Box box;                       // Bounds of the projected variant (empty for none)
+    Preconditioner preconditioner; // Diagonal preconditioner (none by default)
+    StepAdaptation adaptation;     // Parameters of the Polyak and hypergradient step sizes
 };
 
 // Descent types
@@ -24,7 +31,18 @@ enum class GradientDescentType
 {
     exponential,
     inverse,
-    armijo
+    armijo,
+    polyak,
+    hypergradient
+};
+
+// State of a run of gradient descent
+template <typename Vector = vector_type>
+struct GradientDescentState : public BasicState<Vector>
+{
+    scalar_type alpha;         // Step size
+    Vector scaling;            // Scaling of the gradient (diagonal preconditioner)
+    Vector previous_direction; // Direction of the previous step (hypergradient)
 };
 
 // Gradient descent algorithm
@@ -37,44 +55,187 @@ public:
     // Constructor with parameters
     GradientDescent(const GradientDescentParams &params) : Method(params), params(params) {}
 
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<GradientDescentState<>>();
+        initialize(*state);
+        return state;
+    }
+
     /**
-     * Run the gradient descent algorithm.
+     * One iteration of the gradient descent algorithm (operator() loops over
+     * it until the run stops).
      *
-     * @return The converged solution
+     * @param base The state of the run, created by start
      *
      * @note The algorithm stops when the norm of the gradient is less than
-     * `tolerance_r` or when the step size is less than `tolerance_s`.
+     * `tolerance_r` or when the step size is less than `tolerance_s`. With
+     * bounds every update is projected on the box and the norm of the
+     * projected gradient \f$ P(x - \nabla f) - x \f$ replaces the norm of
+     * the gradient.
+     *
+     * @note With a diagonal preconditioner the step is taken along
+     * \f$ D \nabla f \f$, where D is the inverse of the (absolute value of
+     * the) diagonal of the Hessian estimated at the initial condition and
+     * then every `interval` iterations, so variables of very different
+     * scales get steps of the right size.
      *
      * @note The algorithm uses a dynamic step size based on the Armijo rule if
      * `T == GradientDescentType::armijo`, an exponential decay of the step size
      * if `T == GradientDescentType::exponential`, or an adaptive inverse decay
      * of the step size (improvement) if `T == GradientDescentType::inverse`.
+     * `T == GradientDescentType::polyak` uses the Polyak step size
+     * \f$ (f(x) - f^*) / (\nabla f \cdot d) \f$ for a known lower bound
+     * \f$ f^* \f$, and `T == GradientDescentType::hypergradient` adapts the
+     * step size by gradient descent on it,
+     * \f$ \alpha_k = \alpha_{k-1} + \beta \nabla f(x_k) \cdot d_{k-1} \f$
+     * (the derivative of \f$ f(x_k) \f$ with respect to \f$ \alpha_{k-1} \f$
+     * only needs the gradients already computed).
      *
      * @note The algorithm also uses a small number \f$ \epsilon \f$ to avoid
      * division by zero.
      */
-    vector_type operator()() const override
+    void step(State &base) const override
+    {
+        iterate(static_cast<GradientDescentState<> &>(base), DirectEvaluator{params.f, params.grad_f}, true).get();
+    }
+
+    /**
+     * Coroutine of a run of the gradient descent algorithm: the iterations of
+     * step, suspended at every evaluation of f and of its gradient, including
+     * the evaluations of the estimates of the preconditioner.
+     */
+    Solve solve() const override
+    {
+        std::unique_ptr<State> base = start();
+        co_await iterate(static_cast<GradientDescentState<> &>(*base), SuspendingEvaluator{params.f, params.grad_f}, false);
+        co_return std::move(base);
+    }
+
+    /**
+     * Run the gradient descent algorithm on callables of any type (e.g.
+     * lambdas) instead of the std::function of the parameters, which are
+     * ignored. The iterations are instantiated on F and G, so the compiler
+     * can inline the evaluations into them, and on fixed-size vectors for
+     * problems of dimension up to max_fixed_dimension (see
+     * dispatch_dimension), so their temporaries are not allocated on the
+     * heap.
+     *
+     * @tparam max_fixed The largest dimension run on fixed-size vectors (0
+     * to run on vector_type, e.g. to compare the two paths)
+     * @param f The function, callable as f(x) with x a vector_type or an
+     * Eigen::Matrix<scalar_type, N, 1> (e.g. a generic lambda)
+     * @param grad_f The gradient of the function, callable as grad_f(x)
+     * @return The last point of the run
+     */
+    template <int_type max_fixed = max_fixed_dimension, typename F, typename G>
+    vector_type minimize(const F &f, const G &grad_f) const
     {
-        vector_type x = Eigen::Map<const vector_type>(params.initial_condition.data(), params.initial_condition.size());
-        scalar_type alpha = params.initial_step;
-        index_type iteration = 0;
+        return dispatch_dimension<max_fixed>(params.initial_condition.size(), [&]<int N>()
+                                  {
+                                      GradientDescentState<Eigen::Matrix<scalar_type, N, 1>> state;
+                                      initialize(state);
+                                      iterate(state, DirectEvaluator{f, grad_f}, false).get();
+                                      std::cout << state.message << std::endl;
+                                      return vector_type(state.x); });
+    }
 
-        for (iteration = 0; iteration < params.max_iterations; ++iteration)
+    // Getters
+    const Params &get_params() const override { return params; }
+    scalar_type get_mu() const { return params.mu; }
+    scalar_type get_sigma() const { return params.sigma; }
+
+    /**
+     * Prints the parameters of the gradient descent algorithm.
+     *
+     * The parameters are: the type of the descent strategy, the initial
+     * condition, the tolerance for the norm of the gradient, the tolerance for
+     * the step size, the initial step size, the maximum number of iterations,
+     * the minimum step size, \f$ \mu \f$ and \f$ \sigma \f$.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the descent strategy at compile time
+        if constexpr (T == GradientDescentType::exponential)
+        {
+            std::cout << "Descend type: exponential decay of the step size" << std::endl;
+        }
+        else if constexpr (T == GradientDescentType::inverse)
         {
+            std::cout << "Descend type: inverse decay of the step size" << std::endl;
+        }
+        else if constexpr (T == GradientDescentType::armijo)
+        {
+            std::cout << "Descend type: Armijo for the step size" << std::endl;
+        }
+        else if constexpr (T == GradientDescentType::polyak)
+        {
+            std::cout << "Descend type: Polyak step size (lower bound of f: " << params.adaptation.lower_bound << ")" << std::endl;
+        }
+        else if constexpr (T == GradientDescentType::hypergradient)
+        {
+            std::cout << "Descend type: hypergradient descent on the step size (rate: " << params.adaptation.hyper_rate << ")" << std::endl;
+        }
+        Method::print();
+        params.box.print();
+        params.preconditioner.print();
+        std::cout << "mu: " << params.mu << std::endl;
+        std::cout << "sigma: " << params.sigma << std::endl;
+    };
+
+private:
+    // Initial condition and step size of a run
+    template <typename Vector>
+    void initialize(GradientDescentState<Vector> &state) const
+    {
+        state.x = params.box.project(params.initial_condition);
+        state.alpha = params.initial_step;
+    }
+
+    /**
+     * Iterations of a run, until it stops (only one if once is true). The
+     * evaluations of f and of its gradient are awaited from the evaluator:
+     * made at once for step and minimize (DirectEvaluator, on the callables
+     * of the parameters or on any callables), suspending the run for solve
+     * (SuspendingEvaluator). f(x) is evaluated once per Armijo search.
+     */
+    template <typename Vector, typename E>
+    Task<> iterate(GradientDescentState<Vector> &state, E evaluator, bool once) const
+    {
+        Vector &x = state.x;
+        scalar_type &alpha = state.alpha;
+        do
+        {
+            const index_type iteration = state.iteration;
+            if (iteration >= params.max_iterations)
+            {
+                state.not_converged();
+                break;
+            }
+
             // Compute the gradient at the current point
             // source of error
-            vector_type grad = params.grad_f(x);
+            const Vector grad = co_await evaluator.gradient(x);
 
-            // Check for convergence (norm of the gradient)
-            scalar_type residual = grad.norm();
+            // Check for convergence (norm of the gradient, projected on the box if there are bounds)
+            const scalar_type residual = params.box.residual(x, grad);
             if (residual < params.tolerance_r)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to residual criterion." << std::endl;
+                state.converged("residual");
                 break;
             }
-            if constexpr (T == GradientDescentType::exponential || T == GradientDescentType::inverse)
+
+            // Estimate of the preconditioner (evaluations in parallel for step and minimize)
+            if (params.preconditioner.due(iteration))
+                state.scaling = co_await evaluator.scaling(params.preconditioner, x, iteration);
+
+            // Direction of the step: the gradient, scaled by the diagonal preconditioner (if any)
+            Vector direction = params.preconditioner.active() ? Vector(state.scaling.cwiseProduct(grad)) : grad;
+            if constexpr (T == GradientDescentType::exponential || T == GradientDescentType::inverse ||
+                          T == GradientDescentType::hypergradient)
             {
-                grad.normalize();
+                direction.normalize();
             }
 
             // Use constexpr if to select the descent strategy at compile time
@@ -90,66 +251,66 @@ public:
             }
             else if constexpr (T == GradientDescentType::armijo)
             {
+                // Armijo rule for the step size (along the projected path if there are bounds)
                 alpha = params.initial_step;
-                // Armijo rule for the step size
-                while (alpha > params.minimum_step && params.f(x) - params.f(x - alpha * grad) < params.sigma * alpha * grad.squaredNorm())
+                const scalar_type fx = co_await evaluator.value(x);
+                Vector trial = x;
+                while (alpha > params.minimum_step)
+                {
+                    params.box.assign(trial, x - alpha * direction);
+                    const scalar_type f_trial = co_await evaluator.value(trial);
+                    const scalar_type decrease = params.box.active() ? grad.dot(x - trial) : alpha * grad.dot(direction);
+                    if (!(fx - f_trial < params.sigma * decrease))
+                        break;
                     alpha *= 0.5;
+                }
+            }
+            else if constexpr (T == GradientDescentType::polyak)
+            {
+                // Polyak step size, from the gap to the lower bound of f
+                const scalar_type fx = co_await evaluator.value(x);
+                alpha = std::max(fx - params.adaptation.lower_bound, 0.0) / grad.dot(direction);
+            }
+            else if constexpr (T == GradientDescentType::hypergradient)
+            {
+                // Hypergradient descent on the step size: d f(x_k) / d alpha_{k-1} = -grad_k . d_{k-1}
+                if (iteration > 0)
+                    alpha = std::max(alpha + params.adaptation.hyper_rate * grad.dot(state.previous_direction), params.minimum_step);
             }
 
-            vector_type x_prev = x;
+            Vector x_prev = x;
 
-            // Update the current point
-            x = x - alpha * grad;
+            // Update the current point (projected on the box in the same loop)
+            params.box.assign(x, x - alpha * direction);
+            if constexpr (T == GradientDescentType::hypergradient)
+            {
+                state.previous_direction.swap(direction);
+            }
 
             // Check for convergence (step size)
             scalar_type step_size = (x - x_prev).norm();
             if (step_size < params.tolerance_s)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to step size criterion." << std::endl;
+                state.converged("step size");
                 break;
             }
-        }
-        if (iteration == params.max_iterations)
-            std::cout << "Not converged (max_iteration = " << iteration << ")" << std::endl;
-
-        return x;
-    };
-
-    // Getters
-    const Params &get_params() const override { return params; }
-    scalar_type get_mu() const { return params.mu; }
-    scalar_type get_sigma() const { return params.sigma; }
-
-    /**
-     * Prints the parameters of the gradient descent algorithm.
-     *
-     * The parameters are: the type of the descent strategy, the initial
-     * condition, the tolerance for the norm of the gradient, the tolerance for
-     * the step size, the initial step size, the maximum number of iterations,
-     * the minimum step size, \f$ \mu \f$ and \f$ \sigma \f$.
-     */
-    void print() const override
-    {
-        // Use constexpr if to select the descent strategy at compile time
-        if constexpr (T == GradientDescentType::exponential)
-        {
-            std::cout << "Descend type: exponential decay of the step size" << std::endl;
-        }
-        else if constexpr (T == GradientDescentType::inverse)
-        {
-            std::cout << "Descend type: inverse decay of the step size" << std::endl;
-        }
-        else if constexpr (T == GradientDescentType::armijo)
-        {
-            std::cout << "Descend type: Armijo for the step size" << std::endl;
-        }
-        Method::print();
-        std::cout << "mu: " << params.mu << std::endl;
-        std::cout << "sigma: " << params.sigma << std::endl;
-    };
+            ++state.iteration;
+        } while (!once && !state.done);
+    }
 
-private:
     GradientDescentParams params;
 };
 
+// Variants of gradient descent in the solver registry (gradient_method_t)
+inline const bool gradient_descent_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<GradientDescent<GradientDescentType::exponential>, GradientDescentParams>("gradient_descent", "Exponential decay");
+    registry.add<GradientDescent<GradientDescentType::inverse>, GradientDescentParams>("gradient_descent", "Inverse decay");
+    registry.add<GradientDescent<GradientDescentType::armijo>, GradientDescentParams>("gradient_descent", "Armijo rule");
+    registry.add<GradientDescent<GradientDescentType::polyak>, GradientDescentParams>("gradient_descent", "Polyak step");
+    registry.add<GradientDescent<GradientDescentType::hypergradient>, GradientDescentParams>("gradient_descent", "Hypergradient");
+    return true;
+}();
+
 #endif // GRADIENT_DESCENT_HPP
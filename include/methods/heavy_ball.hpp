@@ -2,6 +2,9 @@
 #define HEAVY_BALL_HPP
 
 #include "method.hpp"
+#include "registry.hpp"
+#include "preconditioner.hpp"
+#include <algorithm> // For std::clamp
 
 // Parameters for the gradient descent algorithm
 struct HeavyBallParams : public Params
@@ -11,12 +14,17 @@ struct HeavyBallParams : public Params
     HeavyBallParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
                     scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
                     int_type max_iterations, scalar_type minimum_step,
-                    scalar_type mu, scalar_type eta)
+                    scalar_type mu, scalar_type eta, Box box = Box(),
+                    Preconditioner preconditioner = Preconditioner(),
+                    StepAdaptation adaptation = StepAdaptation())
         : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
                  initial_step, max_iterations, minimum_step),
-          mu(mu), eta(eta) {}
-    scalar_type mu;  // Paramter for the exponential decay and the inverse decay
-    scalar_type eta; // Memory parameter
+          mu(mu), eta(eta), box(box), preconditioner(preconditioner), adaptation(adaptation) {}
+    scalar_type mu;                // Paramter for the exponential decay and the inverse decay
+    scalar_type eta;               // Memory parameter
+    Box box;                       // Bounds of the projected variant (empty for none)
+    Preconditioner preconditioner; // Diagonal preconditioner (none by default)
+    StepAdaptation adaptation;     // Parameters of the Polyak and hypergradient step sizes
 };
 
 // Descent types
@@ -24,7 +32,9 @@ enum class HeavyBallType
 {
     exponential,
     inverse,
-    constant
+    constant,
+    polyak,
+    hypergradient
 };
 
 enum class HeavyBallStrategy
@@ -33,6 +43,16 @@ enum class HeavyBallStrategy
     constant
 };
 
+// State of a run of the heavy ball method
+template <typename Vector = vector_type>
+struct HeavyBallState : public BasicState<Vector>
+{
+    scalar_type alpha;         // Step size
+    Vector d;                  // Last step (momentum)
+    Vector scaling;            // Scaling of the gradient (diagonal preconditioner)
+    Vector previous_direction; // Direction of the previous step (hypergradient)
+};
+
 // Heavy ball algorithm
 // T is the type of the descent strategy
 // S is the type of the memory strategy
@@ -44,92 +64,83 @@ public:
     // Constructor with parameters
     HeavyBall(const HeavyBallParams &params) : Method(params), params(params) {}
 
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<HeavyBallState<>>();
+        initialize(*state);
+        return state;
+    }
+
     /**
-     * Run the Heavy Ball algorithm.
-     *
-     * This function takes no arguments and returns the converged solution.
+     * One iteration of the Heavy Ball algorithm (operator() loops over it
+     * until the run stops).
      *
-     * @return The converged solution
+     * @param base The state of the run, created by start
      *
      * @note The algorithm stops when the norm of the gradient is less than
-     * `tolerance_r` or when the step size is less than `tolerance_s`.
+     * `tolerance_r` or when the step size is less than `tolerance_s`. With
+     * bounds every update is projected on the box (the momentum is the
+     * projected step) and the norm of the projected gradient replaces the
+     * norm of the gradient.
+     *
+     * @note With a diagonal preconditioner the gradient is scaled by the
+     * inverse of the (absolute value of the) diagonal of the Hessian,
+     * estimated at the initial condition and then every `interval`
+     * iterations, before it is normalized.
+     *
+     * @note `T == HeavyBallType::polyak` takes the Polyak step size, the gap
+     * to the known lower bound of f over the slope along the direction, and
+     * `T == HeavyBallType::hypergradient` adapts the step size online with
+     * the product of the new gradient and the previous direction. Neither
+     * needs evaluations of the gradient beyond the one of the iteration.
      *
      * @note The algorithm also uses a small number \f$ \epsilon \f$ to avoid
      * division by zero.
      */
-    vector_type operator()() const override
+    void step(State &base) const override
     {
-        vector_type x = Eigen::Map<const vector_type>(params.initial_condition.data(), params.initial_condition.size());
-        scalar_type alpha = params.initial_step;
-        index_type iteration = 0;
-        vector_type d = vector_type::Zero(params.initial_condition.size());
-
-        for (iteration = 0; iteration < params.max_iterations; ++iteration)
-        {
-            // Compute the gradient at the current point
-            vector_type grad = Eigen::Map<const vector_type>(params.grad_f(x).data(), params.grad_f(x).size());
-
-            // Check for convergence (norm of the gradient)
-            scalar_type residual = grad.norm();
-            if (residual < params.tolerance_r)
-            {
-                std::cout << "Converged in " << iteration << " iterations thanks to residual criterion." << std::endl;
-                break;
-            }
-
-            // Normalization of the gradient
-            grad.normalize();
-
-            // Use constexpr if to select the descent strategy at compile time
-            if (alpha > params.minimum_step)
-            {
-                if constexpr (T == HeavyBallType::exponential)
-                {
-                    // Exponential decay of the step size
-                    alpha *= std::exp(-params.mu);
-                }
-                else if constexpr (T == HeavyBallType::inverse)
-                {
-                    // Adaptive inverse decay of the step size (improvement)
-                    alpha = params.initial_step / (1 + params.mu * iteration * (1 / residual));
-                }
-                // if constexpr (T == HeavyBallType:constant) // not needed
-            }
-
-            // Update the current point
-            if constexpr (S == HeavyBallStrategy::dynamic)
-            {
-                if (alpha < 1)
-                {
-                    d = (1.0 - alpha) * d - alpha * grad;
-                    x = x + d;
-                }
-                else
-                {
-                    d = params.eta * d - alpha * grad;
-                    x = x + d;
-                }
-            }
-            else if constexpr (S == HeavyBallStrategy::constant)
-            {
-                d = params.eta * d - alpha * grad;
-                x = x + d;
-            }
-
-            // Check for convergence (step size)
-            scalar_type step_size = d.norm();
-            if (step_size < params.tolerance_s)
-            {
-                std::cout << "Converged in " << iteration << " iterations thanks to step size criterion." << std::endl;
-                break;
-            }
-        }
+        iterate(static_cast<HeavyBallState<> &>(base), DirectEvaluator{params.f, params.grad_f}, true).get();
+    }
 
-        if (iteration == params.max_iterations)
-            std::cout << "Not converged (max_iteration = " << iteration << ")" << std::endl;
+    /**
+     * Coroutine of a run of the Heavy Ball algorithm: the iterations of step,
+     * suspended at every evaluation of f and of its gradient, including the
+     * evaluations of the estimates of the preconditioner.
+     */
+    Solve solve() const override
+    {
+        std::unique_ptr<State> base = start();
+        co_await iterate(static_cast<HeavyBallState<> &>(*base), SuspendingEvaluator{params.f, params.grad_f}, false);
+        co_return std::move(base);
+    }
 
-        return x;
-    };
+    /**
+     * Run the Heavy Ball algorithm on callables of any type (e.g. lambdas)
+     * instead of the std::function of the parameters, which are ignored. The
+     * iterations are instantiated on F and G, so the compiler can inline the
+     * evaluations into them, and on fixed-size vectors for problems of
+     * dimension up to max_fixed_dimension (see dispatch_dimension), so their
+     * temporaries are not allocated on the heap.
+     *
+     * @tparam max_fixed The largest dimension run on fixed-size vectors (0
+     * to run on vector_type, e.g. to compare the two paths)
+     * @param f The function, callable as f(x) with x a vector_type or an
+     * Eigen::Matrix<scalar_type, N, 1> (e.g. a generic lambda)
+     * @param grad_f The gradient of the function, callable as grad_f(x)
+     * @return The last point of the run
+     */
+    template <int_type max_fixed = max_fixed_dimension, typename F, typename G>
+    vector_type minimize(const F &f, const G &grad_f) const
+    {
+        return dispatch_dimension<max_fixed>(params.initial_condition.size(), [&]<int N>()
+                                  {
+                                      HeavyBallState<Eigen::Matrix<scalar_type, N, 1>> state;
+                                      initialize(state);
+                                      iterate(state, DirectEvaluator{f, grad_f}, false).get();
+                                      std::cout << state.message << std::endl;
+                                      return vector_type(state.x); });
+    }
 
     // Getters
     const Params &get_params() const override { return params; }
@@ -160,6 +171,14 @@ public:
         {
             std::cout << "Descend type: constant step size" << std::endl;
         }
+        else if constexpr (T == HeavyBallType::polyak)
+        {
+            std::cout << "Descend type: Polyak step size (lower bound of f: " << params.adaptation.lower_bound << ")" << std::endl;
+        }
+        else if constexpr (T == HeavyBallType::hypergradient)
+        {
+            std::cout << "Descend type: hypergradient descent on the step size (rate: " << params.adaptation.hyper_rate << ")" << std::endl;
+        }
         if constexpr (S == HeavyBallStrategy::constant)
         {
             std::cout << "Strategy to compute the momentum: constant (eta)" << std::endl;
@@ -169,12 +188,155 @@ public:
             std::cout << "Strategy to compute the momentum: dynamic (1-aplha)" << std::endl;
         }
         Method::print();
+        params.box.print();
+        params.preconditioner.print();
         std::cout << "mu: " << params.mu << std::endl;
         std::cout << "eta: " << params.eta << std::endl;
     };
 
 private:
+    // Initial state of a run
+    template <typename Vector>
+    void initialize(HeavyBallState<Vector> &state) const
+    {
+        state.x = params.box.project(params.initial_condition);
+        state.alpha = params.initial_step;
+        state.d = Vector::Zero(params.initial_condition.size());
+    }
+
+    /**
+     * Iterations of a run, until it stops (only one if once is true). The
+     * evaluations of f and of its gradient are awaited from the evaluator:
+     * made at once for step and minimize (DirectEvaluator, on the callables
+     * of the parameters or on any callables), suspending the run for solve
+     * (SuspendingEvaluator).
+     */
+    template <typename Vector, typename E>
+    Task<> iterate(HeavyBallState<Vector> &state, E evaluator, bool once) const
+    {
+        Vector &x = state.x;
+        Vector &d = state.d;
+        scalar_type &alpha = state.alpha;
+        do
+        {
+            const index_type iteration = state.iteration;
+            if (iteration >= params.max_iterations)
+            {
+                state.not_converged();
+                break;
+            }
+
+            // Compute the gradient at the current point
+            Vector grad = co_await evaluator.gradient(x);
+
+            // Check for convergence (norm of the gradient, projected on the box if there are bounds)
+            const scalar_type residual = params.box.residual(x, grad);
+            if (residual < params.tolerance_r)
+            {
+                state.converged("residual");
+                break;
+            }
+
+            // Estimate of the preconditioner (evaluations in parallel for step and minimize)
+            if (params.preconditioner.due(iteration))
+                state.scaling = co_await evaluator.scaling(params.preconditioner, x, iteration);
+
+            if constexpr (T == HeavyBallType::hypergradient)
+            {
+                // Hypergradient descent on the step size: d f(x_k) / d alpha_{k-1} = -grad_k . d_{k-1}
+                if (iteration > 0)
+                    alpha = std::max(alpha + params.adaptation.hyper_rate * grad.dot(state.previous_direction), params.minimum_step);
+            }
+
+            // Scaling of the gradient by the diagonal preconditioner (if any)
+            if (params.preconditioner.active())
+                grad.array() *= state.scaling.array();
+
+            // Use constexpr if to select the descent strategy at compile time
+            if (alpha > params.minimum_step)
+            {
+                if constexpr (T == HeavyBallType::exponential)
+                {
+                    // Exponential decay of the step size
+                    alpha *= std::exp(-params.mu);
+                }
+                else if constexpr (T == HeavyBallType::inverse)
+                {
+                    // Adaptive inverse decay of the step size (improvement)
+                    alpha = params.initial_step / (1 + params.mu * iteration * (1 / residual));
+                }
+                // if constexpr (T == HeavyBallType:constant) // not needed
+            }
+
+            if constexpr (T == HeavyBallType::polyak)
+            {
+                // Polyak step size: gap to the lower bound of f over the slope along the normalized direction
+                const scalar_type fx = co_await evaluator.value(x);
+                const scalar_type slope = params.preconditioner.active() ? (grad.array().square() / state.scaling.array()).sum() / grad.norm() : grad.norm();
+                alpha = std::max(fx - params.adaptation.lower_bound, 0.0) / slope;
+            }
+
+            // Normalization of the gradient
+            grad.normalize();
+
+            // Memory parameter of the update
+            scalar_type eta = params.eta;
+            if constexpr (S == HeavyBallStrategy::dynamic)
+            {
+                if (alpha < 1)
+                    eta = 1.0 - alpha;
+            }
+            // if constexpr (S == HeavyBallStrategy::constant) // not needed
+
+            // Update the current point (with bounds, the projection and the new step are computed in the same loop)
+            if (params.box.active())
+            {
+                for (index_type i = 0; i < x.size(); ++i)
+                {
+                    const scalar_type x_i = std::clamp(x(i) + eta * d(i) - alpha * grad(i), params.box.lower(i), params.box.upper(i));
+                    d(i) = x_i - x(i);
+                    x(i) = x_i;
+                }
+            }
+            else
+            {
+                d = eta * d - alpha * grad;
+                x = x + d;
+            }
+            if constexpr (T == HeavyBallType::hypergradient)
+            {
+                state.previous_direction.swap(grad);
+            }
+
+            // Check for convergence (step size)
+            scalar_type step_size = d.norm();
+            if (step_size < params.tolerance_s)
+            {
+                state.converged("step size");
+                break;
+            }
+            ++state.iteration;
+        } while (!once && !state.done);
+    }
+
     HeavyBallParams params;
 };
 
+// Variants of heavy ball in the solver registry (heavy_ball_t and heavy_ball_s)
+inline const bool heavy_ball_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<HeavyBall<HeavyBallType::exponential, HeavyBallStrategy::dynamic>, HeavyBallParams>("heavy_ball", "Exponential decay", "Dynamic");
+    registry.add<HeavyBall<HeavyBallType::exponential, HeavyBallStrategy::constant>, HeavyBallParams>("heavy_ball", "Exponential decay", "Constant");
+    registry.add<HeavyBall<HeavyBallType::inverse, HeavyBallStrategy::dynamic>, HeavyBallParams>("heavy_ball", "Inverse decay", "Dynamic");
+    registry.add<HeavyBall<HeavyBallType::inverse, HeavyBallStrategy::constant>, HeavyBallParams>("heavy_ball", "Inverse decay", "Constant");
+    registry.add<HeavyBall<HeavyBallType::constant, HeavyBallStrategy::dynamic>, HeavyBallParams>("heavy_ball", "Constant", "Dynamic");
+    registry.add<HeavyBall<HeavyBallType::constant, HeavyBallStrategy::constant>, HeavyBallParams>("heavy_ball", "Constant", "Constant");
+    registry.add<HeavyBall<HeavyBallType::polyak, HeavyBallStrategy::dynamic>, HeavyBallParams>("heavy_ball", "Polyak step", "Dynamic");
+    registry.add<HeavyBall<HeavyBallType::polyak, HeavyBallStrategy::constant>, HeavyBallParams>("heavy_ball", "Polyak step", "Constant");
+    registry.add<HeavyBall<HeavyBallType::hypergradient, HeavyBallStrategy::dynamic>, HeavyBallParams>("heavy_ball", "Hypergradient", "Dynamic");
+    registry.add<HeavyBall<HeavyBallType::hypergradient, HeavyBallStrategy::constant>, HeavyBallParams>("heavy_ball", "Hypergradient", "Constant");
+    return true;
+}();
+
 #endif // HEAVY_BALL_HPP
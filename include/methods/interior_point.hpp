@@ -0,0 +1,464 @@
+#ifndef INTERIOR_POINT_HPP
+#define INTERIOR_POINT_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <Eigen/Sparse>
+#include <algorithm> // For std::copy_if
+#include <numeric>
+#include <set>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+// Parameters for the primal-dual interior point method
+struct InteriorPointParams : public Params
+{
+    InteriorPointParams() = default;
+    // Constructor for InteriorPointParams
+    InteriorPointParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                        scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                        int_type max_iterations, scalar_type minimum_step,
+                        vector_function eq_constraints, matrix_function jac_eq_constraints,
+                        vector_function ineq_constraints, matrix_function jac_ineq_constraints,
+                        std::vector<std::vector<index_type>> term_variables,
+                        std::vector<std::vector<index_type>> eq_variables,
+                        std::vector<std::vector<index_type>> ineq_variables)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          eq_constraints(eq_constraints), jac_eq_constraints(jac_eq_constraints),
+          ineq_constraints(ineq_constraints), jac_ineq_constraints(jac_ineq_constraints),
+          term_variables(term_variables), eq_variables(eq_variables), ineq_variables(ineq_variables) {}
+    vector_function eq_constraints;                      // Equality constraints h(x) = 0 (empty for none)
+    matrix_function jac_eq_constraints;                  // Jacobian of h
+    vector_function ineq_constraints;                    // Inequality constraints g(x) <= 0 (empty for none)
+    matrix_function jac_ineq_constraints;                // Jacobian of g
+    std::vector<std::vector<index_type>> term_variables; // Variables of each additive term of f (empty for a dense Hessian)
+    std::vector<std::vector<index_type>> eq_variables;   // Variables of each equality constraint (empty for dense rows)
+    std::vector<std::vector<index_type>> ineq_variables; // Variables of each inequality constraint (empty for dense rows)
+};
+
+// Value and gradient of f, constraints and Jacobians at a point
+struct InteriorPointEvaluation
+{
+    scalar_type fx;
+    vector_type grad_f;
+    vector_type hx;
+    matrix_type Jh;
+    vector_type gx;
+    matrix_type Jg;
+};
+
+// State of a run of the interior point method
+struct InteriorPointState : public State
+{
+    InteriorPointEvaluation e;                               // Evaluation at the current point
+    std::vector<std::vector<index_type>> eq_rows, ineq_rows; // Variables of the rows of the Jacobians
+    std::vector<std::vector<index_type>> neighbours;         // Pattern of the Hessian of the Lagrangian
+    std::vector<index_type> color;                           // Color of each variable
+    index_type colors;                                       // Number of colors
+    Eigen::SparseMatrix<scalar_type> K;                      // KKT matrix
+    vector_type s, y, z;                                     // Slacks and multipliers
+    scalar_type mu;                                          // Barrier parameter
+    scalar_type delta_w = 0.0;                               // Last correction of the inertia
+    scalar_type nu = 1.0;                                    // Weight of the violation in the merit function
+
+    // Factorization of the KKT matrix (the symbolic part is computed once)
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<scalar_type>, Eigen::Lower> ldlt;
+};
+
+// Primal-dual interior point method for min f(x) subject to h(x) = 0 and g(x) <= 0
+class InteriorPoint : public Method
+{
+
+public:
+    // Constructor with parameters
+    InteriorPoint(const InteriorPointParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: the sparsity structure, the symbolic factorization and the primal-dual initial point
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<InteriorPointState>();
+        const index_type n = params.initial_condition.size();
+        state->x = params.initial_condition;
+        state->e = evaluate(state->x);
+        const Evaluation &e = state->e;
+        const index_type me = e.hx.size(), mi = e.gx.size();
+
+        // Sparsity structure: rows of the Jacobians, groups of variables of the Hessian and their colors
+        state->eq_rows = rows(params.eq_variables, me, n);
+        state->ineq_rows = rows(params.ineq_variables, mi, n);
+        std::vector<std::vector<index_type>> groups = rows(params.term_variables, params.term_variables.empty() ? 1 : params.term_variables.size(), n);
+        groups.insert(groups.end(), state->eq_rows.begin(), state->eq_rows.end());
+        groups.insert(groups.end(), state->ineq_rows.begin(), state->ineq_rows.end());
+        state->neighbours = neighbourhoods(groups, n);
+        std::tie(state->color, state->colors) = coloring(state->neighbours, n);
+
+        // Symbolic factorization of the KKT matrix, computed once
+        state->K.resize(n + me, n + me);
+        assemble(state->K, state->neighbours, state->eq_rows, state->ineq_rows, matrix_type::Zero(n, state->colors), state->color, e, vector_type::Zero(mi), 0.0);
+        state->ldlt.analyzePattern(state->K);
+
+        // Primal-dual initial point
+        state->s = (-e.gx).cwiseMax(1.0);
+        state->z = vector_type::Ones(mi);
+        state->y = vector_type::Zero(me);
+        state->mu = mi > 0 ? 0.1 * state->s.dot(state->z) / mi : 0.0;
+        return state;
+    }
+
+    /**
+     * One iteration of the primal-dual interior point method (operator()
+     * loops over it until the run stops).
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The inequalities are written as g(x) + s = 0 with slacks s > 0
+     * and the barrier -mu sum log(s). Every iteration takes a Newton step on
+     * the perturbed KKT conditions
+     * \f[
+     *     \nabla f + J_h^T y + J_g^T z = 0, \quad h = 0, \quad g + s = 0, \quad S z = \mu e,
+     * \f]
+     * where the slacks and the multipliers z are eliminated, so that only
+     * the symmetric quasi-definite system
+     * \f[
+     *     \begin{pmatrix} W + \delta_w I & J_h^T \\ J_h & -\delta_c I \end{pmatrix}
+     *     \begin{pmatrix} \Delta x \\ \Delta y \end{pmatrix} = - \begin{pmatrix} r_x \\ r_h \end{pmatrix},
+     *     \quad W = \nabla^2 L + J_g^T S^{-1} Z J_g,
+     * \f]
+     * is solved. The sparsity pattern of this KKT matrix depends only on
+     * which variables appear in the terms of f and in the constraints, so it
+     * is built once: the sparse LDL^T factorization is analyzed (ordering and
+     * elimination tree) only at the beginning and every iteration repeats
+     * only the numeric factorization. The Hessian of the Lagrangian is
+     * approximated by differences of its gradient along groups of
+     * structurally orthogonal columns (evaluated in parallel), so its cost
+     * grows with the number of groups instead of the dimension. If the
+     * inertia of the factorization is wrong (W is not positive definite on
+     * the null space of J_h) delta_w is increased. The step is limited by the
+     * fraction to the boundary rule (s and z stay positive) and shortened
+     * until the l1 merit function f - mu sum log(s) + nu (|h|_1 + |g + s|_1)
+     * decreases enough, and mu follows the average complementarity s^T z / m.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<InteriorPointState &>(base);
+        vector_type &x = state.x;
+        Evaluation &e = state.e;
+        vector_type &s = state.s;
+        vector_type &y = state.y;
+        vector_type &z = state.z;
+        scalar_type &mu = state.mu;
+        scalar_type &delta_w = state.delta_w;
+        scalar_type &nu = state.nu;
+        sparse_matrix_type &K = state.K;
+        const auto &neighbours = state.neighbours;
+        const auto &eq_rows = state.eq_rows;
+        const auto &ineq_rows = state.ineq_rows;
+        const auto &color = state.color;
+        const index_type colors = state.colors;
+        auto &ldlt = state.ldlt;
+        const index_type n = x.size(), me = e.hx.size(), mi = e.gx.size();
+        if (state.iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Check for convergence (residual of the unperturbed KKT conditions)
+        const Residual r = residual(e, s, y, z, mu);
+        const scalar_type complementarity = mi > 0 ? s.dot(z) / mi : 0.0;
+        if (std::max({norm_inf(r.x), norm_inf(r.h), norm_inf(r.g), complementarity}) < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+
+        // Numeric factorization of the KKT matrix, with the smallest delta_w that gives the right inertia
+        const matrix_type D = hessian_differences(x, e, y, z, color, colors);
+        const vector_type sigma = z.cwiseQuotient(s);
+        scalar_type delta = 0.0;
+        while (true)
+        {
+            assemble(K, neighbours, eq_rows, ineq_rows, D, color, e, sigma, delta);
+            ldlt.factorize(K);
+            if (ldlt.info() == Eigen::Success && inertia(ldlt.vectorD(), n, me))
+                break;
+            delta = delta == 0.0 ? (delta_w == 0.0 ? 1e-4 : std::max(delta_w / 3.0, 1e-20)) : 10.0 * delta;
+            if (delta > 1e20)
+                break;
+        }
+        delta_w = delta;
+
+        // Newton direction (the slacks and the multipliers z are recovered from the reduced solution)
+        vector_type rhs(n + me);
+        rhs.head(n) = -(r.x + e.Jg.transpose() * (sigma.cwiseProduct(r.g) - r.c.cwiseQuotient(s)));
+        rhs.tail(me) = -r.h;
+        const vector_type solution = ldlt.solve(rhs);
+        const vector_type dx = solution.head(n);
+        const vector_type dy = solution.tail(me);
+        const vector_type ds = -r.g - e.Jg * dx;
+        const vector_type dz = -(r.c + z.cwiseProduct(ds)).cwiseQuotient(s);
+
+        // Fraction to the boundary rule, then backtracking on the l1 merit function
+        const scalar_type tau = std::max(0.99, 1.0 - mu);
+        const scalar_type alpha_z = boundary_step(z, dz, tau);
+        scalar_type alpha = boundary_step(s, ds, tau);
+        nu = std::max({nu, 2.0 * norm_inf(y + dy), 2.0 * norm_inf(z + dz)});
+        const scalar_type merit = merit_function(e, s, mu, nu);
+        const scalar_type slope = e.grad_f.dot(dx) - mu * ds.cwiseQuotient(s).sum() -
+                                  nu * (e.hx.lpNorm<1>() + (e.gx + s).lpNorm<1>());
+        vector_type x_new = x + alpha * dx;
+        Evaluation e_new = evaluate(x_new);
+        while (alpha > params.minimum_step &&
+               !(merit_function(e_new, s + alpha * ds, mu, nu) <= merit + 1e-4 * alpha * std::min(slope, 0.0)))
+        {
+            alpha *= 0.5;
+            x_new = x + alpha * dx;
+            e_new = evaluate(x_new);
+        }
+
+        x = x_new;
+        e = std::move(e_new);
+        s += alpha * ds;
+        y += alpha * dy;
+        z += alpha_z * dz;
+        if (mi > 0)
+            mu = 0.1 * s.dot(z) / mi;
+
+        // Check for convergence (step size)
+        if (alpha * dx.norm() < params.tolerance_s)
+        {
+            ++state.iteration;
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    }
+
+    // Print the parameters of the method
+    void print() const override
+    {
+        std::cout << "KKT system: sparse LDL^T with the symbolic factorization reused" << std::endl;
+        Method::print();
+    };
+
+private:
+    InteriorPointParams params;
+
+    using sparse_matrix_type = Eigen::SparseMatrix<scalar_type>;
+
+    using Evaluation = InteriorPointEvaluation;
+
+    // Residual of the perturbed KKT conditions
+    struct Residual
+    {
+        vector_type x; // Gradient of the Lagrangian
+        vector_type h; // Equality constraints
+        vector_type g; // Inequality constraints with slacks
+        vector_type c; // Perturbed complementarity
+        scalar_type norm() const
+        {
+            return std::sqrt(x.squaredNorm() + h.squaredNorm() + g.squaredNorm() + c.squaredNorm());
+        }
+    };
+
+    static scalar_type norm_inf(const vector_type &v) { return v.size() > 0 ? v.cwiseAbs().maxCoeff() : 0.0; }
+
+    // Value and gradient of f, constraints and Jacobians at x, evaluated concurrently
+    Evaluation evaluate(const vector_type &x) const
+    {
+        Evaluation e{0.0, vector_type(), vector_type(0), matrix_type(0, x.size()), vector_type(0), matrix_type(0, x.size())};
+        tbb::parallel_invoke([&]
+                             { e.fx = params.f(x); },
+                             [&]
+                             { e.grad_f = params.grad_f(x); },
+                             [&]
+                             { if (params.eq_constraints) e.hx = params.eq_constraints(x); },
+                             [&]
+                             { if (params.eq_constraints) e.Jh = params.jac_eq_constraints(x); },
+                             [&]
+                             { if (params.ineq_constraints) e.gx = params.ineq_constraints(x); },
+                             [&]
+                             { if (params.ineq_constraints) e.Jg = params.jac_ineq_constraints(x); });
+        return e;
+    }
+
+    // Barrier objective plus nu times the l1 norm of the violation of the constraints
+    static scalar_type merit_function(const Evaluation &e, const vector_type &s, scalar_type mu, scalar_type nu)
+    {
+        return e.fx - mu * s.array().log().sum() + nu * (e.hx.lpNorm<1>() + (e.gx + s).lpNorm<1>());
+    }
+
+    static Residual residual(const Evaluation &e, const vector_type &s, const vector_type &y,
+                             const vector_type &z, scalar_type mu)
+    {
+        return {e.grad_f + e.Jh.transpose() * y + e.Jg.transpose() * z,
+                e.hx,
+                e.gx + s,
+                (s.cwiseProduct(z).array() - mu).matrix()};
+    }
+
+    /**
+     * Variables of m rows of a structure (all the variables if the
+     * structure is not given for every row).
+     */
+    static std::vector<std::vector<index_type>> rows(const std::vector<std::vector<index_type>> &variables,
+                                                     std::size_t m, index_type n)
+    {
+        if (variables.size() == m)
+        {
+            std::vector<std::vector<index_type>> valid(m);
+            for (std::size_t r = 0; r < m; ++r)
+                std::copy_if(variables[r].begin(), variables[r].end(), std::back_inserter(valid[r]), [n](index_type i)
+                             { return i >= 0 && i < n; });
+            return valid;
+        }
+        std::vector<index_type> all(n);
+        std::iota(all.begin(), all.end(), 0);
+        return std::vector<std::vector<index_type>>(m, all);
+    }
+
+    /**
+     * Sorted variables sharing a group with each variable (the variable
+     * itself included): the nonzeros of the columns of the Hessian of the
+     * Lagrangian.
+     */
+    static std::vector<std::vector<index_type>> neighbourhoods(const std::vector<std::vector<index_type>> &groups, index_type n)
+    {
+        std::vector<std::set<index_type>> sets(n);
+        for (index_type i = 0; i < n; ++i)
+            sets[i].insert(i);
+        for (const auto &group : groups)
+            for (index_type i : group)
+                for (index_type j : group)
+                    sets[i].insert(j);
+        std::vector<std::vector<index_type>> neighbours(n);
+        for (index_type i = 0; i < n; ++i)
+            neighbours[i].assign(sets[i].begin(), sets[i].end());
+        return neighbours;
+    }
+
+    /**
+     * Greedy coloring of the columns of the Hessian such that no two
+     * columns of a color have a nonzero in the same row, so that one
+     * difference of the gradient of the Lagrangian gives all of them.
+     *
+     * @return The color of each column and the number of colors
+     */
+    static std::pair<std::vector<index_type>, index_type> coloring(const std::vector<std::vector<index_type>> &neighbours, index_type n)
+    {
+        std::vector<index_type> color(n, -1);
+        index_type colors = 0;
+        for (index_type j = 0; j < n; ++j)
+        {
+            std::set<index_type> used;
+            for (index_type i : neighbours[j])
+                for (index_type k : neighbours[i])
+                    if (color[k] >= 0)
+                        used.insert(color[k]);
+            index_type c = 0;
+            while (used.count(c))
+                ++c;
+            color[j] = c;
+            colors = std::max(colors, c + 1);
+        }
+        return {color, colors};
+    }
+
+    /**
+     * Differences of the gradient of the Lagrangian along the sums of the
+     * unit vectors of each color, divided by the step: column c holds the
+     * columns of the Hessian of color c. The colors are evaluated in
+     * parallel, each thread with its own copies of the functions.
+     */
+    matrix_type hessian_differences(const vector_type &x, const Evaluation &e, const vector_type &y,
+                                    const vector_type &z, const std::vector<index_type> &color, index_type colors) const
+    {
+        const scalar_type step = 1e-6 * (1.0 + norm_inf(x));
+        const vector_type base = e.grad_f + e.Jh.transpose() * y + e.Jg.transpose() * z;
+        struct Functions
+        {
+            vector_function grad_f;
+            matrix_function jac_h;
+            matrix_function jac_g;
+        };
+        tbb::enumerable_thread_specific<Functions> functions(Functions{params.grad_f, params.jac_eq_constraints, params.jac_ineq_constraints});
+
+        matrix_type D(x.size(), colors);
+        tbb::parallel_for(index_type(0), colors, [&](index_type c)
+                          {
+                              const Functions &local = functions.local();
+                              vector_type shifted = x;
+                              for (index_type j = 0; j < x.size(); ++j)
+                                  if (color[j] == c)
+                                      shifted(j) += step;
+                              vector_type gradient = local.grad_f(shifted);
+                              if (y.size() > 0)
+                                  gradient += local.jac_h(shifted).transpose() * y;
+                              if (z.size() > 0)
+                                  gradient += local.jac_g(shifted).transpose() * z;
+                              D.col(c) = (gradient - base) / step; });
+        return D;
+    }
+
+    /**
+     * Assemble the lower triangle of the KKT matrix. Every entry of the
+     * pattern is inserted, also when its value is zero, so the structure is
+     * the same at every iteration and the symbolic factorization stays valid.
+     */
+    static void assemble(sparse_matrix_type &K, const std::vector<std::vector<index_type>> &neighbours,
+                         const std::vector<std::vector<index_type>> &eq_rows,
+                         const std::vector<std::vector<index_type>> &ineq_rows,
+                         const matrix_type &D, const std::vector<index_type> &color, const Evaluation &e,
+                         const vector_type &sigma, scalar_type delta)
+    {
+        const index_type n = neighbours.size();
+        std::vector<Eigen::Triplet<scalar_type>> triplets;
+        // Symmetrized Hessian of the Lagrangian, plus the correction of the inertia
+        for (index_type j = 0; j < n; ++j)
+            for (index_type i : neighbours[j])
+                if (i >= j)
+                    triplets.emplace_back(i, j, 0.5 * (D(i, color[j]) + D(j, color[i])) + (i == j ? delta : 0.0));
+        // Barrier term J_g^T S^{-1} Z J_g (its pattern is contained in the one of the Hessian)
+        for (std::size_t r = 0; r < ineq_rows.size(); ++r)
+            for (index_type i : ineq_rows[r])
+                for (index_type j : ineq_rows[r])
+                    if (i >= j)
+                        triplets.emplace_back(i, j, sigma(r) * e.Jg(r, i) * e.Jg(r, j));
+        // Jacobian of the equality constraints and regularization of the multipliers
+        for (std::size_t r = 0; r < eq_rows.size(); ++r)
+        {
+            for (index_type j : eq_rows[r])
+                triplets.emplace_back(n + r, j, e.Jh(r, j));
+            triplets.emplace_back(n + r, n + r, -1e-8);
+        }
+        K.setFromTriplets(triplets.begin(), triplets.end());
+    }
+
+    // True if the factorization has n positive and m negative pivots (in any order, because of the fill-reducing permutation)
+    static bool inertia(const vector_type &pivots, index_type n, index_type m)
+    {
+        return (pivots.array() > 0.0).count() == n && (pivots.array() < 0.0).count() == m;
+    }
+
+    // Largest step in (0, 1] such that v + alpha dv >= (1 - tau) v
+    static scalar_type boundary_step(const vector_type &v, const vector_type &dv, scalar_type tau)
+    {
+        scalar_type alpha = 1.0;
+        for (index_type i = 0; i < v.size(); ++i)
+            if (dv(i) < 0.0)
+                alpha = std::min(alpha, -tau * v(i) / dv(i));
+        return alpha;
+    }
+};
+
+// The interior point method in the solver registry (there is only one variant)
+inline const bool interior_point_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<InteriorPoint, InteriorPointParams>("interior_point");
+    return true;
+}();
+
+#endif // INTERIOR_POINT_HPP
@@ -0,0 +1,248 @@
+#ifndef LEVENBERG_MARQUARDT_HPP
+#define LEVENBERG_MARQUARDT_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+
+// Parameters for the Levenberg-Marquardt algorithm
+struct LevenbergMarquardtParams : public Params
+{
+    LevenbergMarquardtParams() = default;
+    // Constructor for LevenbergMarquardtParams
+    LevenbergMarquardtParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                             scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                             int_type max_iterations, scalar_type minimum_step,
+                             vector_function residuals, matrix_function jacobian, scalar_type lambda)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          residuals(residuals), jacobian(jacobian), lambda(lambda) {}
+    vector_function residuals; // Residuals r(x), the objective is f(x) = 1/2 ||r(x)||^2
+    matrix_function jacobian;  // Jacobian of the residuals
+    scalar_type lambda;        // Initial damping parameter
+};
+
+// Descent types
+enum class LevenbergMarquardtType
+{
+    gauss_newton,
+    levenberg_marquardt
+};
+
+// State of a run of the Levenberg-Marquardt method
+struct LevenbergMarquardtState : public State
+{
+    vector_type r;                              // Residuals at the current point
+    matrix_type J;                              // Jacobian at the current point
+    scalar_type lambda;                         // Damping parameter
+    scalar_type nu;                             // Growth factor of the damping
+    matrix_type A;                              // Matrix of the linear least squares problem
+    vector_type b;                              // Right hand side of the linear least squares problem
+    Eigen::ColPivHouseholderQR<matrix_type> qr; // QR factorization, allocated once
+};
+
+// Levenberg-Marquardt algorithm for nonlinear least squares problems
+// T is the type of the globalization strategy
+template <LevenbergMarquardtType T>
+class LevenbergMarquardt : public Method
+{
+
+public:
+    // Constructor with parameters
+    LevenbergMarquardt(const LevenbergMarquardtParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<LevenbergMarquardtState>();
+        state->x = params.initial_condition;
+        state->r = params.residuals(state->x);
+        state->J = params.jacobian(state->x);
+        state->lambda = params.lambda;
+        state->nu = 2.0;
+
+        // Workspace of the linear least squares problem (the damping rows are
+        // not needed by Gauss-Newton)
+        const index_type m = state->r.size();
+        const index_type n = state->x.size();
+        const index_type rows = (T == LevenbergMarquardtType::levenberg_marquardt) ? m + n : m;
+        state->A = matrix_type::Zero(rows, n);
+        state->b = vector_type::Zero(rows);
+        state->qr = Eigen::ColPivHouseholderQR<matrix_type>(rows, n);
+        return state;
+    }
+
+    /**
+     * One iteration of the Levenberg-Marquardt algorithm (operator() loops
+     * over it until the run stops).
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The algorithm stops when the norm of the gradient \f$ J^T r \f$ is
+     * less than `tolerance_r` or when the step size is less than `tolerance_s`.
+     *
+     * @note The step \f$ p \f$ solves the damped linear least squares problem
+     * \f[
+     *     \min_p \left\| \begin{bmatrix} J \\ \sqrt{\lambda} I \end{bmatrix} p
+     *     + \begin{bmatrix} r \\ 0 \end{bmatrix} \right\|
+     * \f]
+     * with a QR factorization, which avoids squaring the condition number of
+     * \f$ J \f$ as the normal equations would do. The matrix and the
+     * factorization are allocated once and reused at every iteration.
+     * If `T == LevenbergMarquardtType::levenberg_marquardt` the damping
+     * \f$ \lambda \f$ is updated with Nielsen's rule, if
+     * `T == LevenbergMarquardtType::gauss_newton` then \f$ \lambda = 0 \f$
+     * and the step is halved until the objective decreases.
+     *
+     * @note The Jacobian is evaluated only after an accepted step, and the
+     * step size criterion is tested only after an accepted step. A damping
+     * that grows beyond max_lambda (repeated rejections) or a Gauss-Newton
+     * step along which the objective does not decrease stops the run as not
+     * converged.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<LevenbergMarquardtState &>(base);
+        vector_type &x = state.x;
+        vector_type &r = state.r;
+        matrix_type &J = state.J;
+        matrix_type &A = state.A;
+        vector_type &b = state.b;
+        scalar_type &lambda = state.lambda;
+        scalar_type &nu = state.nu;
+        const index_type m = r.size();
+        const index_type n = x.size();
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Gradient of f = 1/2 ||r||^2
+        vector_type grad = J.transpose() * r;
+
+        // Check for convergence (norm of the gradient)
+        scalar_type residual = grad.norm();
+        if (residual < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+
+        // Assemble and solve the linear least squares problem
+        A.topRows(m) = J;
+        if constexpr (T == LevenbergMarquardtType::levenberg_marquardt)
+        {
+            A.bottomRows(n).setIdentity();
+            A.bottomRows(n) *= std::sqrt(lambda);
+        }
+        b.head(m) = -r;
+        state.qr.compute(A);
+        vector_type p = state.qr.solve(b);
+
+        scalar_type step_size = 0.0;
+        if constexpr (T == LevenbergMarquardtType::levenberg_marquardt)
+        {
+            // Ratio between actual and predicted reduction
+            vector_type x_new = x + p;
+            vector_type r_new = params.residuals(x_new);
+            scalar_type actual = 0.5 * (r.squaredNorm() - r_new.squaredNorm());
+            scalar_type predicted = 0.5 * (r.squaredNorm() - (r + J * p).squaredNorm());
+            scalar_type rho = predicted > 0.0 ? actual / predicted : -1.0;
+
+            if (!(rho > 0.0))
+            {
+                // Reject the step and increase the damping (a rejected step says nothing about convergence)
+                lambda *= nu;
+                nu *= 2.0;
+                ++state.iteration;
+                if (!(lambda < max_lambda))
+                    state.stop("Not converged (damping blow-up after " + std::to_string(state.iteration) + " iterations)");
+                return;
+            }
+
+            // Accept the step and reduce the damping
+            x = x_new;
+            r = r_new;
+            J = params.jacobian(x);
+            lambda *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * rho - 1.0, 3));
+            nu = 2.0;
+            step_size = p.norm();
+        }
+        else if constexpr (T == LevenbergMarquardtType::gauss_newton)
+        {
+            // Halve the step until the objective decreases
+            scalar_type alpha = params.initial_step;
+            vector_type r_new = params.residuals(x + alpha * p);
+            while (alpha > params.minimum_step && r_new.squaredNorm() >= r.squaredNorm())
+            {
+                alpha *= 0.5;
+                r_new = params.residuals(x + alpha * p);
+            }
+            if (!(r_new.squaredNorm() < r.squaredNorm()))
+            {
+                // No step of length at least minimum_step decreases the objective
+                state.stop("Not converged (no decrease along the Gauss-Newton step after " +
+                           std::to_string(iteration) + " iterations)");
+                return;
+            }
+            x = x + alpha * p;
+            r = r_new;
+            J = params.jacobian(x);
+            step_size = alpha * p.norm();
+        }
+
+        // Check for convergence (size of the accepted step)
+        if (step_size < params.tolerance_s)
+        {
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_function get_residuals() const { return params.residuals; }
+    matrix_function get_jacobian() const { return params.jacobian; }
+    scalar_type get_lambda() const { return params.lambda; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the globalization strategy, initial condition,
+     * tolerance_r, tolerance_s, initial step, maximum iterations, minimum step
+     * and the initial damping lambda.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the globalization strategy at compile time
+        if constexpr (T == LevenbergMarquardtType::levenberg_marquardt)
+        {
+            std::cout << "Descend type: Levenberg-Marquardt (adaptive damping)" << std::endl;
+        }
+        else if constexpr (T == LevenbergMarquardtType::gauss_newton)
+        {
+            std::cout << "Descend type: Gauss-Newton (step halving)" << std::endl;
+        }
+        Method::print();
+        std::cout << "lambda: " << params.lambda << std::endl;
+    };
+
+private:
+    LevenbergMarquardtParams params;
+
+    // Damping beyond which the steps are negligible and the run is stopped
+    static constexpr scalar_type max_lambda = 1e16;
+};
+
+// Variants of Levenberg-Marquardt in the solver registry (levenberg_marquardt_t)
+inline const bool levenberg_marquardt_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<LevenbergMarquardt<LevenbergMarquardtType::levenberg_marquardt>, LevenbergMarquardtParams>("levenberg_marquardt", "Levenberg-Marquardt");
+    registry.add<LevenbergMarquardt<LevenbergMarquardtType::gauss_newton>, LevenbergMarquardtParams>("levenberg_marquardt", "Gauss-Newton");
+    return true;
+}();
+
+#endif // LEVENBERG_MARQUARDT_HPP
@@ -2,6 +2,15 @@
 #define METHOD_HPP
 
 #include <Math>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 // Parameters for the gradient descent algorithm
 struct Params
@@ -29,6 +38,428 @@ struct Params
     virtual ~Params() {}
 };
 
+// Box lower <= x <= upper of the projected variants of the first-order methods (empty bounds for none)
+struct Box
+{
+    vector_type lower; // Lower corner
+    vector_type upper; // Upper corner
+
+    bool active() const { return lower.size() > 0; }
+
+    // Projection of x on the box
+    template <typename Vector>
+    Vector project(const Vector &x) const
+    {
+        return active() ? Vector(x.cwiseMax(lower).cwiseMin(upper)) : x;
+    }
+
+    /**
+     * Assign an update to x, projected on the box. The projection is part of
+     * the same expression, so it is evaluated in the loop of the update.
+     */
+    template <typename Vector, typename Expression>
+    void assign(Vector &x, const Eigen::MatrixBase<Expression> &update) const
+    {
+        if (active())
+            x = update.cwiseMax(lower).cwiseMin(upper);
+        else
+            x = update;
+    }
+
+    // Norm of the projected gradient P(x - grad) - x (the norm of the gradient if there are no bounds)
+    template <typename Vector>
+    scalar_type residual(const Vector &x, const Vector &grad) const
+    {
+        return active() ? ((x - grad).cwiseMax(lower).cwiseMin(upper) - x).norm() : grad.norm();
+    }
+
+    // Print the bounds (if any)
+    void print() const
+    {
+        if (!active())
+            return;
+        Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+        std::cout << "lower_bounds: " << lower.format(commaFormat) << std::endl;
+        std::cout << "upper_bounds: " << upper.format(commaFormat) << std::endl;
+    }
+};
+
+// Parameters of the online adaptation of the step size (Polyak and hypergradient step size types)
+struct StepAdaptation
+{
+    scalar_type lower_bound = 0.0; // Known lower bound f* of f (Polyak step size)
+    scalar_type hyper_rate = 1e-3; // Learning rate of the step size (hypergradient descent)
+};
+
+/**
+ * State of a run of a method, advanced one iteration at a time by
+ * Method::step. Every method extends it with the variables of its loop, so a
+ * run can be interleaved with other runs, inspected or checkpointed between
+ * two iterations. Vector is the type of the points: vector_type for the
+ * Method interface, a fixed-size vector for the runs of the first-order
+ * methods on small problems (see dispatch_dimension).
+ */
+template <typename Vector = vector_type>
+struct BasicState
+{
+    Vector x;                 // Current point (the best point for the global methods)
+    index_type iteration = 0; // Number of completed iterations
+    bool done = false;        // True when the run has stopped
+    string_type message;      // Reason of the stop
+
+    // Stop the run
+    void stop(const string_type &reason)
+    {
+        done = true;
+        message = reason;
+    }
+
+    // Stop the run thanks to a convergence criterion ("residual", "step size", ...)
+    void converged(const string_type &criterion)
+    {
+        stop("Converged in " + std::to_string(iteration) + " iterations thanks to " + criterion + " criterion.");
+    }
+
+    // Stop the run at the maximum number of iterations
+    void not_converged()
+    {
+        stop("Not converged (max_iteration = " + std::to_string(iteration) + ")");
+    }
+
+    virtual ~BasicState() {}
+};
+
+// State of a run of the Method interface
+using State = BasicState<>;
+
+// Largest dimension with an instantiation on fixed-size vectors
+inline constexpr int_type max_fixed_dimension = 8;
+
+/**
+ * Call run.template operator()<N>() with N = n for 1 <= n <= max_fixed
+ * and with N = Eigen::Dynamic otherwise, so that the small problems run on
+ * Eigen::Matrix<scalar_type, N, 1>, whose temporaries live on the stack,
+ * and the others on vector_type.
+ *
+ * @tparam max_fixed The largest dimension run on fixed-size vectors (at most
+ * max_fixed_dimension, 0 to always run on vector_type)
+ * @param n The dimension of the problem
+ * @param run A generic lambda with an int template parameter
+ * @return The result of the call
+ */
+template <int_type max_fixed = max_fixed_dimension, typename Run>
+decltype(auto) dispatch_dimension(index_type n, Run &&run)
+{
+    static_assert(max_fixed <= max_fixed_dimension);
+    if (n > max_fixed)
+        return run.template operator()<Eigen::Dynamic>();
+    switch (n)
+    {
+    case 1:
+        return run.template operator()<1>();
+    case 2:
+        return run.template operator()<2>();
+    case 3:
+        return run.template operator()<3>();
+    case 4:
+        return run.template operator()<4>();
+    case 5:
+        return run.template operator()<5>();
+    case 6:
+        return run.template operator()<6>();
+    case 7:
+        return run.template operator()<7>();
+    case 8:
+        return run.template operator()<8>();
+    default:
+        return run.template operator()<Eigen::Dynamic>();
+    }
+}
+
+// Evaluation of f or of its gradient requested by a suspended run (see Solve)
+struct EvaluationRequest
+{
+    const scalar_function *f = nullptr;      // Function to evaluate (nullptr for a gradient)
+    const vector_function *grad_f = nullptr; // Gradient to evaluate (nullptr for a value)
+    const vector_type *x = nullptr;          // Point of the evaluation
+    scalar_type value = 0.0;                 // Value of f at x
+    vector_type gradient;                    // Gradient of f at x
+
+    void evaluate()
+    {
+        if (f)
+            value = (*f)(*x);
+        else
+            gradient = (*grad_f)(*x);
+    }
+};
+
+/**
+ * Coroutine of a run of a method (see Method::solve). The run suspends at
+ * every evaluation of f or of its gradient (co_await evaluate(f, x)), also
+ * the ones awaited by the Tasks it awaits, and leaves the request in its
+ * promise, so that a scheduler can evaluate the requests of many runs
+ * together before resuming them (see BatchScheduler). The result of the
+ * coroutine is the final state of the run.
+ */
+class Solve
+{
+public:
+    struct promise_type
+    {
+        std::unique_ptr<State> state;         // Final state of the run
+        EvaluationRequest *request = nullptr; // Pending evaluation (nullptr if there is none)
+        std::coroutine_handle<> active;       // Task suspended on the pending evaluation (nullptr for the run itself)
+        std::exception_ptr error;             // Exception thrown by the run
+
+        Solve get_return_object() { return Solve(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(std::unique_ptr<State> final_state) { state = std::move(final_state); }
+        void unhandled_exception() { error = std::current_exception(); }
+        promise_type &root() { return *this; }
+    };
+
+    Solve(Solve &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Solve &operator=(Solve &&other) noexcept
+    {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+    Solve(const Solve &) = delete;
+    Solve &operator=(const Solve &) = delete;
+    ~Solve()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    // True if the run has stopped
+    bool done() const { return handle.done(); }
+
+    // Pending evaluation of the suspended run
+    EvaluationRequest &request() const { return *handle.promise().request; }
+
+    // Resume the run (or the Task that made the request) until its next evaluation (or its end)
+    void resume()
+    {
+        promise_type &promise = handle.promise();
+        const std::coroutine_handle<> next = promise.active ? promise.active : handle;
+        promise.request = nullptr;
+        promise.active = nullptr;
+        next.resume();
+        if (handle.promise().error)
+            std::rethrow_exception(handle.promise().error);
+    }
+
+    // Final state of the run (once it has stopped)
+    std::unique_ptr<State> result() { return std::move(handle.promise().state); }
+
+    // Run to the end, evaluating every request as soon as it is made
+    std::unique_ptr<State> get()
+    {
+        for (resume(); !done(); resume())
+            request().evaluate();
+        return result();
+    }
+
+private:
+    explicit Solve(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Awaitable evaluation of f (Result = scalar_type) or of its gradient (Result = vector_type)
+template <typename Result>
+struct Evaluation
+{
+    EvaluationRequest request;
+
+    bool await_ready() const noexcept { return false; }
+
+    // The request suspends the whole run, awaited directly by it or by one of its Tasks
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> awaiting) noexcept
+    {
+        Solve::promise_type &run = awaiting.promise().root();
+        run.request = &request;
+        run.active = awaiting;
+    }
+    Result await_resume()
+    {
+        if constexpr (std::is_same_v<Result, scalar_type>)
+            return request.value;
+        else
+            return std::move(request.gradient);
+    }
+};
+
+// Evaluation of f at x in the coroutine of a run: co_await evaluate(f, x)
+inline Evaluation<scalar_type> evaluate(const scalar_function &f, const vector_type &x)
+{
+    return {{.f = &f, .grad_f = nullptr, .x = &x, .value = 0.0, .gradient = vector_type()}};
+}
+
+// Evaluation of the gradient at x in the coroutine of a run: co_await evaluate(grad_f, x)
+inline Evaluation<vector_type> evaluate(const vector_function &grad_f, const vector_type &x)
+{
+    return {{.f = nullptr, .grad_f = &grad_f, .x = &x, .value = 0.0, .gradient = vector_type()}};
+}
+
+// Result of a Task (nothing for Task<void>)
+template <typename T>
+struct TaskResult
+{
+    std::optional<T> value;
+
+    void return_value(T result) { value = std::move(result); }
+    T result() { return std::move(*value); }
+};
+
+template <>
+struct TaskResult<void>
+{
+    void return_void() {}
+    void result() {}
+};
+
+/**
+ * Coroutine of a part of a run (e.g. the iterations of a first-order method
+ * or an estimate of its preconditioner), awaited by the coroutine of the run
+ * or by another Task: co_await iterate(state, evaluator). The evaluations it
+ * awaits from a SuspendingEvaluator suspend the whole run, and Solve::resume
+ * resumes the Task that made the request. With a DirectEvaluator nothing
+ * suspends, so the same Task also runs to the end at once (get), as in
+ * Method::step.
+ */
+template <typename T = void>
+class Task
+{
+public:
+    struct promise_type : TaskResult<T>
+    {
+        Solve::promise_type *run = nullptr; // Promise of the run (nullptr for a Task run at once)
+        std::coroutine_handle<> awaiting;   // Coroutine that awaits the Task (nullptr for a Task run at once)
+        std::exception_ptr error;           // Exception thrown by the Task
+
+        // At the end, the coroutine that awaits the Task goes on in its place
+        struct Return
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> task) noexcept
+            {
+                const std::coroutine_handle<> awaiting = task.promise().awaiting;
+                return awaiting ? awaiting : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        Return final_suspend() noexcept { return {}; }
+        void unhandled_exception() { error = std::current_exception(); }
+        Solve::promise_type &root() { return *run; }
+    };
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    // Awaited by a run or by another Task: it starts at once and suspends with them
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) noexcept
+    {
+        handle.promise().run = &awaiting.promise().root();
+        handle.promise().awaiting = awaiting;
+        return handle;
+    }
+    T await_resume() { return result(); }
+
+    // Run to the end at once (only for a Task that awaits no suspending evaluation)
+    T get()
+    {
+        handle.resume();
+        return result();
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    T result()
+    {
+        if (handle.promise().error)
+            std::rethrow_exception(handle.promise().error);
+        return handle.promise().result();
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Result of an evaluation made at once (see DirectEvaluator): awaiting it does not suspend
+template <typename Result>
+struct Ready
+{
+    Result result;
+
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    Result await_resume() { return std::move(result); }
+};
+
+/**
+ * Evaluations of the Tasks that run at once (Method::step and the minimize
+ * of the first-order methods): f and its gradient, callables of any type,
+ * are called when their evaluations are awaited, so the Task never suspends
+ * and the compiler can inline them.
+ */
+template <typename F, typename G>
+struct DirectEvaluator
+{
+    const F &f;
+    const G &grad_f;
+
+    template <typename Vector>
+    Ready<scalar_type> value(const Vector &x) const { return {f(x)}; }
+
+    template <typename Vector>
+    Ready<Vector> gradient(const Vector &x) const { return {Vector(grad_f(x))}; }
+
+    // Estimate of a preconditioner at x (evaluations in parallel)
+    template <typename P, typename Vector>
+    Ready<Vector> scaling(const P &preconditioner, const Vector &x, index_type seed) const
+    {
+        return {preconditioner.scaling(f, grad_f, x, seed)};
+    }
+};
+
+/**
+ * Evaluations of the Tasks awaited by the coroutine of a run (Method::solve):
+ * every evaluation of f and of its gradient suspends the run, for the
+ * schedulers that evaluate the requests of many runs together.
+ */
+struct SuspendingEvaluator
+{
+    const scalar_function &f;
+    const vector_function &grad_f;
+
+    Evaluation<scalar_type> value(const vector_type &x) const { return evaluate(f, x); }
+
+    Evaluation<vector_type> gradient(const vector_type &x) const { return evaluate(grad_f, x); }
+
+    // Estimate of a preconditioner at x, one evaluation at a time
+    template <typename P>
+    Task<vector_type> scaling(const P &preconditioner, const vector_type &x, index_type seed) const
+    {
+        return preconditioner.estimate(*this, x, seed);
+    }
+};
+
 class Method
 {
 
@@ -36,8 +467,43 @@ public:
     // Constructor with paramters
     Method(const Params &params) : params(params) {}
 
-    // Run the algorithm
-    virtual vector_type operator()() const = 0;
+    // Initial state of a run, at the initial condition
+    virtual std::unique_ptr<State> start() const = 0;
+
+    // Advance a run (created by start) by one iteration
+    virtual void step(State &state) const = 0;
+
+    /**
+     * Run the algorithm: a loop over step until the run stops, then the
+     * reason of the stop is printed.
+     *
+     * @return The last point of the run
+     */
+    virtual vector_type operator()() const
+    {
+        const std::unique_ptr<State> state = start();
+        while (!state->done)
+            step(*state);
+        std::cout << state->message << std::endl;
+        return state->x;
+    }
+
+    /**
+     * Coroutine of a run, for the schedulers that interleave many runs on a
+     * few threads (see BatchScheduler). By default the whole loop over step
+     * runs when the coroutine is first resumed; the first-order methods
+     * override it to suspend at every evaluation of f and of its gradient.
+     *
+     * @return The coroutine, suspended before the first iteration (the
+     * method must outlive it)
+     */
+    virtual Solve solve() const
+    {
+        std::unique_ptr<State> state = start();
+        while (!state->done)
+            step(*state);
+        co_return std::move(state);
+    }
 
     /**
      * Run the algorithm.
@@ -101,4 +567,38 @@ private:
     Params params;
 };
 
+// Stream buffer that discards its output
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Silences std::cout while at least one SilentCout is alive
+// (e.g. while several solvers run concurrently, or for the inner solvers of a method)
+class SilentCout
+{
+public:
+    SilentCout()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (depth++ == 0)
+            saved = std::cout.rdbuf(&buffer);
+    }
+    ~SilentCout()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--depth == 0)
+            std::cout.rdbuf(saved);
+    }
+    SilentCout(const SilentCout &) = delete;
+    SilentCout &operator=(const SilentCout &) = delete;
+
+private:
+    inline static std::mutex mutex;
+    inline static int_type depth = 0;
+    inline static std::streambuf *saved = nullptr;
+    inline static NullBuffer buffer;
+};
+
 #endif // METHOD_HPP
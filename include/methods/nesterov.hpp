@@ -2,6 +2,7 @@
 #define NESTEROV_HPP
 
 #include "method.hpp"
+#include "registry.hpp"
 
 // Parameters for the gradient descent algorithm
 struct NesterovParams : public Params
@@ -11,12 +12,15 @@ struct NesterovParams : public Params
     NesterovParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
                    scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
                    int_type max_iterations, scalar_type minimum_step,
-                   scalar_type mu, scalar_type eta)
+                   scalar_type mu, scalar_type eta, Box box = Box(),
+                   StepAdaptation adaptation = StepAdaptation())
         : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
                  initial_step, max_iterations, minimum_step),
-          mu(mu), eta(eta) {}
-    scalar_type mu;  // Parameter for the exponential decay and the inverse decay
-    scalar_type eta; // Memory parameter
+          mu(mu), eta(eta), box(box), adaptation(adaptation) {}
+    scalar_type mu;            // Parameter for the exponential decay and the inverse decay
+    scalar_type eta;           // Memory parameter
+    Box box;                   // Bounds of the projected variant (empty for none)
+    StepAdaptation adaptation; // Parameters of the Polyak and hypergradient step sizes
 };
 
 // Descent types
@@ -24,7 +28,9 @@ enum class NesterovType
 {
     exponential,
     inverse,
-    constant
+    constant,
+    polyak,
+    hypergradient
 };
 
 enum class NesterovStrategy
@@ -33,6 +39,15 @@ enum class NesterovStrategy
     constant
 };
 
+// State of a run of the Nesterov method
+template <typename Vector = vector_type>
+struct NesterovState : public BasicState<Vector>
+{
+    scalar_type alpha;         // Step size
+    Vector y;                  // Extrapolated point
+    Vector previous_direction; // Direction of the previous step (hypergradient)
+};
+
 // Nesterov algorithm
 // T is the type of the descent strategy
 template <NesterovType T, NesterovStrategy S>
@@ -43,45 +58,178 @@ public:
     // Constructor with parameters
     Nesterov(const NesterovParams &params) : Method(params), params(params) {}
 
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<NesterovState<>>();
+        initialize(*state);
+        return state;
+    }
+
     /**
-     * Run the Nesterov algorithm.
+     * One iteration of the Nesterov algorithm (operator() loops over it until
+     * the run stops).
      *
-     * @return The converged solution
+     * @param base The state of the run, created by start
      *
      * @note The algorithm stops when the norm of the gradient is less than
-     * `tolerance_r` or when the step size is less than `tolerance_s`.
+     * `tolerance_r` or when the step size is less than `tolerance_s`. With
+     * bounds every update of x is projected on the box (the extrapolated
+     * point y may leave it) and the norm of the projected gradient replaces
+     * the norm of the gradient.
      *
      * @note The algorithm uses a dynamic step size based on the Armijo rule if
      * `T == NesterovType::exponential`, an adaptive inverse decay of the step
      * size (improvement) if `T == NesterovType::inverse`, or a constant step
-     * size if `T == NesterovType::constant`.
+     * size if `T == NesterovType::constant`. `T == NesterovType::polyak`
+     * takes the Polyak step size from y, \f$ (f(y) - f^*) / \|\nabla f(y)\| \f$,
+     * and `T == NesterovType::hypergradient` adapts the step size with the
+     * product of the gradient at the new point and the previous direction.
      *
      * @note The algorithm also uses a small number \f$ \epsilon \f$ to avoid
      * division by zero.
      */
-    vector_type operator()() const override
+    void step(State &base) const override
+    {
+        iterate(static_cast<NesterovState<> &>(base), DirectEvaluator{params.f, params.grad_f}, true).get();
+    }
+
+    /**
+     * Coroutine of a run of the Nesterov algorithm: the iterations of step,
+     * suspended at every evaluation of f and of its gradient.
+     */
+    Solve solve() const override
+    {
+        std::unique_ptr<State> base = start();
+        co_await iterate(static_cast<NesterovState<> &>(*base), SuspendingEvaluator{params.f, params.grad_f}, false);
+        co_return std::move(base);
+    }
+
+    /**
+     * Run the Nesterov algorithm on callables of any type (e.g. lambdas)
+     * instead of the std::function of the parameters, which are ignored. The
+     * iterations are instantiated on F and G, so the compiler can inline the
+     * evaluations into them, and on fixed-size vectors for problems of
+     * dimension up to max_fixed_dimension (see dispatch_dimension), so their
+     * temporaries are not allocated on the heap.
+     *
+     * @tparam max_fixed The largest dimension run on fixed-size vectors (0
+     * to run on vector_type, e.g. to compare the two paths)
+     * @param f The function, callable as f(x) with x a vector_type or an
+     * Eigen::Matrix<scalar_type, N, 1> (e.g. a generic lambda)
+     * @param grad_f The gradient of the function, callable as grad_f(x)
+     * @return The last point of the run
+     */
+    template <int_type max_fixed = max_fixed_dimension, typename F, typename G>
+    vector_type minimize(const F &f, const G &grad_f) const
     {
-        vector_type x = Eigen::Map<const vector_type>(params.initial_condition.data(), params.initial_condition.size());
-        scalar_type alpha = params.initial_step;
-        index_type iteration = 0;
-        vector_type y = Eigen::Map<const vector_type>(params.initial_condition.data(), params.initial_condition.size());
+        return dispatch_dimension<max_fixed>(params.initial_condition.size(), [&]<int N>()
+                                  {
+                                      NesterovState<Eigen::Matrix<scalar_type, N, 1>> state;
+                                      initialize(state);
+                                      iterate(state, DirectEvaluator{f, grad_f}, false).get();
+                                      std::cout << state.message << std::endl;
+                                      return vector_type(state.x); });
+    }
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    scalar_type get_mu() const { return params.mu; }
+    scalar_type get_eta() const { return params.eta; }
 
-        for (iteration = 0; iteration < params.max_iterations; ++iteration)
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: initial condition, tolerance_r, tolerance_s,
+     * initial step, maximum iterations, minimum step, mu, and eta.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the descent strategy at compile time
+        if constexpr (T == NesterovType::exponential)
+        {
+            std::cout << "Descend type: exponential decay of the step size" << std::endl;
+        }
+        else if constexpr (T == NesterovType::inverse)
+        {
+            std::cout << "Descend type: inverse decay of the step size" << std::endl;
+        }
+        else if constexpr (T == NesterovType::constant)
+        {
+            std::cout << "Descend type: constant step size" << std::endl;
+        }
+        else if constexpr (T == NesterovType::polyak)
+        {
+            std::cout << "Descend type: Polyak step size (lower bound of f: " << params.adaptation.lower_bound << ")" << std::endl;
+        }
+        else if constexpr (T == NesterovType::hypergradient)
+        {
+            std::cout << "Descend type: hypergradient descent on the step size (rate: " << params.adaptation.hyper_rate << ")" << std::endl;
+        }
+        if constexpr (S == NesterovStrategy::constant)
+        {
+            std::cout << "Strategy to compute the momentum: constant (eta)" << std::endl;
+        }
+        else if constexpr (S == NesterovStrategy::dynamic)
         {
-            // Compute the gradient at the current point and in auxiliary vector y
-            vector_type grad = Eigen::Map<const vector_type>(params.grad_f(x).data(), params.grad_f(x).size());
-            vector_type grad_y = Eigen::Map<const vector_type>(params.grad_f(y).data(), params.grad_f(y).size());
+            std::cout << "Strategy to compute the momentum: dynamic (1-aplha)" << std::endl;
+        }
+        Method::print();
+        params.box.print();
+        std::cout << "mu: " << params.mu << std::endl;
+        std::cout << "eta: " << params.eta << std::endl;
+    };
 
-            // Check for convergence (norm of the gradient)
-            scalar_type residual = grad.norm();
+private:
+    // Initial state of a run
+    template <typename Vector>
+    void initialize(NesterovState<Vector> &state) const
+    {
+        state.x = params.box.project(params.initial_condition);
+        state.alpha = params.initial_step;
+        state.y = state.x;
+    }
+
+    /**
+     * Iterations of a run, until it stops (only one if once is true). The
+     * evaluations of f and of its gradient are awaited from the evaluator:
+     * made at once for step and minimize (DirectEvaluator, on the callables
+     * of the parameters or on any callables), suspending the run for solve
+     * (SuspendingEvaluator). The gradient at y is not evaluated once the
+     * residual has converged.
+     */
+    template <typename Vector, typename E>
+    Task<> iterate(NesterovState<Vector> &state, E evaluator, bool once) const
+    {
+        Vector &x = state.x;
+        Vector &y = state.y;
+        scalar_type &alpha = state.alpha;
+        do
+        {
+            const index_type iteration = state.iteration;
+            if (iteration >= params.max_iterations)
+            {
+                state.not_converged();
+                break;
+            }
+
+            // Compute the gradient at the current point
+            const Vector grad = co_await evaluator.gradient(x);
+
+            // Check for convergence (norm of the gradient, projected on the box if there are bounds)
+            scalar_type residual = params.box.residual(x, grad);
             if (residual < params.tolerance_r)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to residual criterion." << std::endl;
+                state.converged("residual");
                 break;
             }
 
-            // Normalization of the gradient
-            grad_y.normalize();
+            if constexpr (T == NesterovType::hypergradient)
+            {
+                // Hypergradient descent on the step size: d f(x_k) / d alpha_{k-1} = -grad_k . d_{k-1}
+                if (iteration > 0)
+                    alpha = std::max(alpha + params.adaptation.hyper_rate * grad.dot(state.previous_direction), params.minimum_step);
+            }
 
             // Use constexpr if to select the descent strategy at compile time
             if (alpha > params.minimum_step)
@@ -99,10 +247,23 @@ public:
                 // if constexpr (T == NesterovType::constant) // not needed
             }
 
-            vector_type x_prev = x;
+            // Compute the gradient in auxiliary vector y
+            Vector grad_y = co_await evaluator.gradient(y);
 
-            // Update the current point
-            x = y - alpha * grad_y;
+            if constexpr (T == NesterovType::polyak)
+            {
+                // Polyak step size, from the gap to the lower bound of f at y
+                const scalar_type fy = co_await evaluator.value(y);
+                alpha = std::max(fy - params.adaptation.lower_bound, 0.0) / grad_y.norm();
+            }
+
+            // Normalization of the gradient
+            grad_y.normalize();
+
+            Vector x_prev = x;
+
+            // Update the current point (projected on the box in the same loop)
+            params.box.assign(x, y - alpha * grad_y);
             if constexpr (S == NesterovStrategy::dynamic)
             {
                 if (alpha < 1)
@@ -118,63 +279,40 @@ public:
             {
                 y = x + params.eta * (x - x_prev);
             }
+            if constexpr (T == NesterovType::hypergradient)
+            {
+                state.previous_direction.swap(grad_y);
+            }
 
             // Check for convergence (step size)
             scalar_type step_size = (x - x_prev).norm();
             if (step_size < params.tolerance_s)
             {
-                std::cout << "Converged in " << iteration << " iterations thanks to step size criterion." << std::endl;
+                state.converged("step size");
                 break;
             }
-        }
-
-        if (iteration == params.max_iterations)
-            std::cout << "Not converged (max_iteration = " << iteration << ")" << std::endl;
-
-        return x;
-    };
-
-    // Getters
-    const Params &get_params() const override { return params; }
-    scalar_type get_mu() const { return params.mu; }
-    scalar_type get_eta() const { return params.eta; }
+            ++state.iteration;
+        } while (!once && !state.done);
+    }
 
-    /**
-     * Prints the parameters of this method.
-     *
-     * The parameters are: initial condition, tolerance_r, tolerance_s,
-     * initial step, maximum iterations, minimum step, mu, and eta.
-     */
-    void print() const override
-    {
-        // Use constexpr if to select the descent strategy at compile time
-        if constexpr (T == NesterovType::exponential)
-        {
-            std::cout << "Descend type: exponential decay of the step size" << std::endl;
-        }
-        else if constexpr (T == NesterovType::inverse)
-        {
-            std::cout << "Descend type: inverse decay of the step size" << std::endl;
-        }
-        else if constexpr (T == NesterovType::constant)
-        {
-            std::cout << "Descend type: constant step size" << std::endl;
-        }
-        if constexpr (S == NesterovStrategy::constant)
-        {
-            std::cout << "Strategy to compute the momentum: constant (eta)" << std::endl;
-        }
-        else if constexpr (S == NesterovStrategy::dynamic)
-        {
-            std::cout << "Strategy to compute the momentum: dynamic (1-aplha)" << std::endl;
-        }
-        Method::print();
-        std::cout << "mu: " << params.mu << std::endl;
-        std::cout << "eta: " << params.eta << std::endl;
-    };
-
-private:
     NesterovParams params;
 };
 
+// Variants of Nesterov's method in the solver registry (nesterov_t and nesterov_s)
+inline const bool nesterov_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<Nesterov<NesterovType::exponential, NesterovStrategy::dynamic>, NesterovParams>("nesterov", "Exponential decay", "Dynamic");
+    registry.add<Nesterov<NesterovType::exponential, NesterovStrategy::constant>, NesterovParams>("nesterov", "Exponential decay", "Constant");
+    registry.add<Nesterov<NesterovType::inverse, NesterovStrategy::dynamic>, NesterovParams>("nesterov", "Inverse decay", "Dynamic");
+    registry.add<Nesterov<NesterovType::inverse, NesterovStrategy::constant>, NesterovParams>("nesterov", "Inverse decay", "Constant");
+    registry.add<Nesterov<NesterovType::constant, NesterovStrategy::dynamic>, NesterovParams>("nesterov", "Constant", "Dynamic");
+    registry.add<Nesterov<NesterovType::constant, NesterovStrategy::constant>, NesterovParams>("nesterov", "Constant", "Constant");
+    registry.add<Nesterov<NesterovType::polyak, NesterovStrategy::dynamic>, NesterovParams>("nesterov", "Polyak step", "Dynamic");
+    registry.add<Nesterov<NesterovType::polyak, NesterovStrategy::constant>, NesterovParams>("nesterov", "Polyak step", "Constant");
+    registry.add<Nesterov<NesterovType::hypergradient, NesterovStrategy::dynamic>, NesterovParams>("nesterov", "Hypergradient", "Dynamic");
+    registry.add<Nesterov<NesterovType::hypergradient, NesterovStrategy::constant>, NesterovParams>("nesterov", "Hypergradient", "Constant");
+    return true;
+}();
+
 #endif // NESTEROV_HPP
@@ -0,0 +1,314 @@
+#ifndef PARTICLE_SWARM_HPP
+#define PARTICLE_SWARM_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <atomic>
+#include <bit> // For std::bit_cast
+#include <cstdint>
+#include <random>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Parameters for the particle swarm algorithm
+struct ParticleSwarmParams : public Params
+{
+    ParticleSwarmParams() = default;
+    // Constructor for ParticleSwarmParams
+    ParticleSwarmParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                        scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                        int_type max_iterations, scalar_type minimum_step,
+                        vector_type lower_bounds, vector_type upper_bounds, int_type population_size,
+                        scalar_type inertia, scalar_type cognitive, scalar_type social)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          lower_bounds(lower_bounds), upper_bounds(upper_bounds), population_size(population_size),
+          inertia(inertia), cognitive(cognitive), social(social) {}
+    vector_type lower_bounds; // Lower corner of the box
+    vector_type upper_bounds; // Upper corner of the box
+    int_type population_size; // Number of particles, 0 for 10 + 2 sqrt(n)
+    scalar_type inertia;      // Inertia weight w of the velocities
+    scalar_type cognitive;    // Acceleration c1 towards the personal best
+    scalar_type social;       // Acceleration c2 towards the global best
+};
+
+// Velocity update rules
+enum class ParticleSwarmType
+{
+    inertia,
+    constriction
+};
+
+// State of a run of particle swarm optimization
+struct ParticleSwarmState : public State
+{
+    ParticleSwarmState(const scalar_function &f) : local_f(f) {}
+    tbb::enumerable_thread_specific<scalar_function> local_f; // Each thread evaluates its own copy of f
+    matrix_type X, V, R1, R2;                                 // Positions, velocities and random matrices
+    matrix_type P;                                            // Personal bests
+    vector_type values;                                       // Values of f at the personal bests
+
+    // Global best (key of the value << 32 | index of the particle)
+    std::atomic<std::uint64_t> global{std::numeric_limits<std::uint64_t>::max()};
+};
+
+// Particle swarm optimization algorithm
+// T is the velocity update rule
+template <ParticleSwarmType T>
+class ParticleSwarm : public Method
+{
+
+public:
+    // Constructor with parameters
+    ParticleSwarm(const ParticleSwarmParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: random particles in the box (the initial condition is the first particle)
+    std::unique_ptr<State> start() const override
+    {
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const vector_type width = upper - lower;
+        const index_type n = lower.size();
+        const index_type p = params.population_size > 0 ? params.population_size
+                                                        : 10 + static_cast<index_type>(2 * std::sqrt(n));
+        auto state = std::make_unique<ParticleSwarmState>(params.f);
+        matrix_type &X = state->X;
+        matrix_type &V = state->V;
+        X.resize(n, p);
+        V.resize(n, p);
+        state->R1.resize(n, p);
+        state->R2.resize(n, p);
+        random_matrices(X, V, 0);
+        X = (X.array().colwise() * width.array()).colwise() + lower.array();
+        V = ((V.array() - 0.5).colwise() * width.array()).matrix();
+        X.col(0) = params.initial_condition.cwiseMax(lower).cwiseMin(upper);
+        state->P = X;
+        state->values.resize(p);
+        tbb::parallel_for(index_type(0), p, [&](index_type k)
+                          {
+                              state->values(k) = state->local_f.local()(X.col(k));
+                              update_global(state->global, state->values(k), k); });
+        state->x = state->P.col(resolve_global(*state));
+        return state;
+    }
+
+    /**
+     * One iteration of the particle swarm algorithm (operator() loops over it
+     * until the run stops). The point of the state is the global best.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The state of the swarm is stored as structure of arrays: positions
+     * X, velocities V and personal bests P are n x p column-major matrices
+     * (one column per particle), so the update
+     * \f[
+     *     V \leftarrow \chi \left( w V + c_1 R_1 \circ (P - X) + c_2 R_2 \circ (g 1^T - X) \right),
+     *     \quad X \leftarrow X + V
+     * \f]
+     * is a sequence of vectorized matrix operations. R1 and R2 are uniform
+     * random matrices and the positions are clamped to the box.
+     *
+     * @note If `T == ParticleSwarmType::inertia` then \f$ \chi = 1 \f$, if
+     * `T == ParticleSwarmType::constriction` then w = 1 and \f$ \chi \f$ is
+     * Clerc's constriction factor for \f$ \varphi = c_1 + c_2 > 4 \f$.
+     *
+     * @note The particles are evaluated in parallel (each thread with its own
+     * copy of f) and each one updates its own personal best. The global best
+     * is a 64 bit record that packs the value of f (as an order preserving
+     * 32 bit key) with the index of the particle, updated with an atomic
+     * compare and swap, so the particles never wait for each other. Since
+     * the key has single precision, the best particle is confirmed in double
+     * precision after the evaluations.
+     *
+     * @note The algorithm stops when the personal bests differ from the
+     * global best by less than `tolerance_r` (residual criterion) or when the
+     * largest velocity is less than `tolerance_s` (step size criterion).
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<ParticleSwarmState &>(base);
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const vector_type width = upper - lower;
+        matrix_type &X = state.X;
+        matrix_type &V = state.V;
+        matrix_type &P = state.P;
+        vector_type &values = state.values;
+        const index_type p = X.cols();
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Coefficients of the velocity update
+        scalar_type chi = 1.0, w = params.inertia;
+        if constexpr (T == ParticleSwarmType::constriction)
+        {
+            const scalar_type phi = params.cognitive + params.social;
+            chi = phi > 4.0 ? 2.0 / std::abs(2.0 - phi - std::sqrt(phi * phi - 4.0 * phi)) : 1.0;
+            w = 1.0;
+        }
+
+        const index_type best = state.global.load() & 0xffffffff;
+
+        // Check for convergence (values of the personal bests)
+        scalar_type residual = values.maxCoeff() - values(best);
+        if (residual < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+
+        // Move the swarm
+        random_matrices(state.R1, state.R2, iteration + 1);
+        V = chi * (w * V + params.cognitive * state.R1.cwiseProduct(P - X) +
+                   params.social * state.R2.cwiseProduct(P.col(best).replicate(1, p) - X));
+        V = V.cwiseMin(width.replicate(1, p)).cwiseMax(-width.replicate(1, p));
+        X = (X + V).cwiseMax(lower.replicate(1, p)).cwiseMin(upper.replicate(1, p));
+
+        // Evaluate the particles and update the bests
+        tbb::parallel_for(index_type(0), p, [&](index_type k)
+                          {
+                              const scalar_type value = state.local_f.local()(X.col(k));
+                              if (value < values(k))
+                              {
+                                  values(k) = value;
+                                  P.col(k) = X.col(k);
+                                  update_global(state.global, value, k);
+                              } });
+        state.x = P.col(resolve_global(state));
+
+        // Check for convergence (step size)
+        scalar_type step_size = V.colwise().norm().maxCoeff();
+        if (step_size < params.tolerance_s)
+        {
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_type get_lower_bounds() const { return params.lower_bounds; }
+    vector_type get_upper_bounds() const { return params.upper_bounds; }
+    int_type get_population_size() const { return params.population_size; }
+    scalar_type get_inertia() const { return params.inertia; }
+    scalar_type get_cognitive() const { return params.cognitive; }
+    scalar_type get_social() const { return params.social; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the velocity update rule, the box, initial
+     * condition (the first particle), tolerance_r, tolerance_s, initial step,
+     * maximum iterations, minimum step, number of particles, inertia,
+     * cognitive and social accelerations.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the velocity update rule at compile time
+        if constexpr (T == ParticleSwarmType::inertia)
+        {
+            std::cout << "Velocity update: inertia weight" << std::endl;
+        }
+        else if constexpr (T == ParticleSwarmType::constriction)
+        {
+            std::cout << "Velocity update: constriction factor (the inertia is not used)" << std::endl;
+        }
+        Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+        std::cout << "lower_bounds: " << params.lower_bounds.format(commaFormat) << std::endl;
+        std::cout << "upper_bounds: " << params.upper_bounds.format(commaFormat) << std::endl;
+        Method::print();
+        std::cout << "population_size: " << params.population_size << std::endl;
+        std::cout << "inertia: " << params.inertia << std::endl;
+        std::cout << "cognitive: " << params.cognitive << std::endl;
+        std::cout << "social: " << params.social << std::endl;
+    };
+
+private:
+    ParticleSwarmParams params;
+
+    /**
+     * Order preserving key of a value: if a < b then key(a) < key(b).
+     *
+     * The value is rounded to single precision, so values that differ only
+     * beyond its precision have the same key.
+     */
+    static std::uint32_t key(scalar_type value)
+    {
+        if (std::isnan(value))
+            value = std::numeric_limits<scalar_type>::infinity();
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(static_cast<float>(value));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+
+    /**
+     * Offer a new personal best to the global best.
+     *
+     * @param global The packed record (key of the value << 32 | index of the particle)
+     * @param value The value of the personal best
+     * @param k The index of the particle
+     */
+    static void update_global(std::atomic<std::uint64_t> &global, scalar_type value, index_type k)
+    {
+        const std::uint64_t record = (static_cast<std::uint64_t>(key(value)) << 32) | static_cast<std::uint32_t>(k);
+        std::uint64_t current = global.load(std::memory_order_relaxed);
+        while (record < current && !global.compare_exchange_weak(current, record, std::memory_order_relaxed))
+            ;
+    }
+
+    /**
+     * Confirm the global best in double precision.
+     *
+     * Values that differ only beyond single precision have the same key, so
+     * the record may hold a near-tie with a lower index. After the
+     * evaluations the best personal best is found exactly (a reduction over
+     * the values) and stored in the record.
+     *
+     * @param state The state of the run
+     * @return The index of the best particle
+     */
+    static index_type resolve_global(ParticleSwarmState &state)
+    {
+        const index_type candidate = state.global.load() & 0xffffffff;
+        index_type best;
+        state.values.minCoeff(&best);
+        if (!(state.values(best) < state.values(candidate)))
+            return candidate;
+        state.global.store((static_cast<std::uint64_t>(key(state.values(best))) << 32) | static_cast<std::uint32_t>(best));
+        return best;
+    }
+
+    /**
+     * Fill two matrices with uniform random numbers in [0, 1).
+     *
+     * The columns are filled in parallel, each one with its own engine
+     * seeded with the iteration and the index of the particle.
+     */
+    void random_matrices(matrix_type &A, matrix_type &B, index_type iteration) const
+    {
+        tbb::parallel_for(index_type(0), A.cols(), [&](index_type k)
+                          {
+                              std::mt19937 engine(static_cast<std::uint32_t>(iteration * 0x9e3779b1u + k));
+                              std::uniform_real_distribution<scalar_type> uniform(0.0, 1.0);
+                              for (index_type i = 0; i < A.rows(); ++i)
+                              {
+                                  A(i, k) = uniform(engine);
+                                  B(i, k) = uniform(engine);
+                              } });
+    }
+};
+
+// Variants of particle swarm optimization in the solver registry (particle_swarm_t)
+inline const bool particle_swarm_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<ParticleSwarm<ParticleSwarmType::inertia>, ParticleSwarmParams>("particle_swarm", "Inertia");
+    registry.add<ParticleSwarm<ParticleSwarmType::constriction>, ParticleSwarmParams>("particle_swarm", "Constriction");
+    return true;
+}();
+
+#endif // PARTICLE_SWARM_HPP
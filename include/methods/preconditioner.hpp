@@ -0,0 +1,199 @@
+#ifndef PRECONDITIONER_HPP
+#define PRECONDITIONER_HPP
+
+#include <Math>
+#include "method.hpp" // For Task
+#include <random>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Estimates of the diagonal of the Hessian
+enum class PreconditionerType
+{
+    none,
+    finite_differences, // Second differences of f along the axes (2n + 1 evaluations of f)
+    hutchinson          // Mean of v * (H v) over random probes v with entries +-1 (2 gradients each)
+};
+
+// Diagonal preconditioner of the first-order methods (no preconditioning by default)
+struct Preconditioner
+{
+    PreconditionerType type = PreconditionerType::none;
+    int_type interval = 0;   // Iterations between two estimates (0 to estimate only at the initial condition)
+    scalar_type h = 1e-3;    // Step of the differences
+    int_type probes = 8;     // Number of random probes (Hutchinson)
+
+    bool active() const { return type != PreconditionerType::none; }
+
+    // True if the diagonal has to be estimated at this iteration
+    bool due(index_type iteration) const
+    {
+        return active() && (iteration == 0 || (interval > 0 && iteration % interval == 0));
+    }
+
+    /**
+     * Inverse of the absolute value of the estimated diagonal of the Hessian
+     * at x, the scaling of the gradient.
+     *
+     * The evaluations of an estimate are independent, so they run in
+     * parallel, each thread with its own copy of f (or of its gradient).
+     * Entries that are zero or much smaller than the largest one (flat or
+     * linear directions) are raised to 1e-8 times the largest one.
+     *
+     * @param f The function
+     * @param grad_f The gradient of the function
+     * @param x The point (vector_type or a fixed-size vector)
+     * @param seed The seed of the random probes
+     * @return The scaling of each component of the gradient
+     */
+    template <typename F, typename G, typename Vector>
+    Vector scaling(const F &f, const G &grad_f, const Vector &x, index_type seed) const
+    {
+        const index_type n = x.size();
+        const index_type m = evaluations(n);
+        if (type == PreconditionerType::finite_differences)
+        {
+            tbb::enumerable_thread_specific<F> functions(f);
+            vector_type values(m);
+            tbb::parallel_for(index_type(0), m, [&](index_type k)
+                              { values(k) = functions.local()(point(x, k, seed)); });
+            return Vector(from_values(values));
+        }
+        if (type == PreconditionerType::hutchinson)
+        {
+            tbb::enumerable_thread_specific<G> gradients(grad_f);
+            matrix_type results(n, m);
+            tbb::parallel_for(index_type(0), m, [&](index_type k)
+                              { results.col(k) = gradients.local()(point(x, k, seed)); });
+            return Vector(from_gradients(results, seed));
+        }
+        return Vector::Ones(n);
+    }
+
+    /**
+     * The same estimate as scaling, made one evaluation at a time: each one
+     * is awaited from the evaluator (a SuspendingEvaluator in the coroutines
+     * of Method::solve, so a scheduler batches it with the evaluations of
+     * other runs).
+     *
+     * @param evaluator The evaluations of f and of its gradient
+     * @param x The point
+     * @param seed The seed of the random probes
+     * @return The Task of the scaling of each component of the gradient
+     */
+    template <typename Evaluator>
+    Task<vector_type> estimate(Evaluator evaluator, vector_type x, index_type seed) const
+    {
+        const index_type n = x.size();
+        const index_type m = evaluations(n);
+        if (type == PreconditionerType::finite_differences)
+        {
+            vector_type values(m);
+            for (index_type k = 0; k < m; ++k)
+            {
+                const vector_type y = point(x, k, seed);
+                values(k) = co_await evaluator.value(y);
+            }
+            co_return from_values(values);
+        }
+        if (type == PreconditionerType::hutchinson)
+        {
+            matrix_type results(n, m);
+            for (index_type k = 0; k < m; ++k)
+            {
+                const vector_type y = point(x, k, seed);
+                results.col(k) = co_await evaluator.gradient(y);
+            }
+            co_return from_gradients(results, seed);
+        }
+        co_return vector_type::Ones(n);
+    }
+
+    // Print the options (if any)
+    void print() const
+    {
+        if (!active())
+            return;
+        std::cout << "preconditioner: " << (type == PreconditionerType::hutchinson ? "Hutchinson" : "Finite differences") << std::endl;
+        std::cout << "precondition_interval: " << interval << std::endl;
+        std::cout << "preconditioner_h: " << h << std::endl;
+        if (type == PreconditionerType::hutchinson)
+            std::cout << "probes: " << probes << std::endl;
+    }
+
+private:
+    // Number of evaluations of an estimate: 2n + 1 values of f (finite differences) or 2 gradients per probe (Hutchinson)
+    index_type evaluations(index_type n) const
+    {
+        if (type == PreconditionerType::finite_differences)
+            return 2 * n + 1;
+        if (type == PreconditionerType::hutchinson)
+            return 2 * probes;
+        return 0;
+    }
+
+    // Point of the k-th evaluation of an estimate at x
+    template <typename Vector>
+    Vector point(const Vector &x, index_type k, index_type seed) const
+    {
+        Vector y = x;
+        if (type == PreconditionerType::finite_differences)
+        {
+            // x, then x + h e_i and x - h e_i for every component i
+            if (k > 0)
+                y((k - 1) / 2) += k % 2 == 1 ? h : -h;
+        }
+        else if (type == PreconditionerType::hutchinson)
+        {
+            // x + h v and x - h v for every probe v
+            y += (k % 2 == 0 ? h : -h) * probe(x.size(), k / 2, seed);
+        }
+        return y;
+    }
+
+    // Scaling from the values of f at the points of a finite differences estimate
+    vector_type from_values(const vector_type &values) const
+    {
+        const index_type n = (values.size() - 1) / 2;
+        vector_type diagonal(n);
+        for (index_type i = 0; i < n; ++i)
+            diagonal(i) = (values(2 * i + 1) - 2.0 * values(0) + values(2 * i + 2)) / (h * h);
+        return inverse(diagonal);
+    }
+
+    // Scaling from the gradients at the points of a Hutchinson estimate (columns)
+    vector_type from_gradients(const matrix_type &gradients, index_type seed) const
+    {
+        const index_type n = gradients.rows();
+        vector_type diagonal = vector_type::Zero(n);
+        for (index_type k = 0; k < probes; ++k)
+        {
+            const vector_type Hv = (gradients.col(2 * k) - gradients.col(2 * k + 1)) / (2.0 * h);
+            diagonal += probe(n, k, seed).cwiseProduct(Hv);
+        }
+        return inverse(diagonal / probes);
+    }
+
+    // Random probe k of the Hutchinson estimate (entries +-1)
+    vector_type probe(index_type n, index_type k, index_type seed) const
+    {
+        std::mt19937 engine(seed * probes + k);
+        std::bernoulli_distribution sign(0.5);
+        vector_type v(n);
+        for (index_type i = 0; i < n; ++i)
+            v(i) = sign(engine) ? 1.0 : -1.0;
+        return v;
+    }
+
+    // Inverse of the absolute value of the diagonal, with the small entries raised
+    vector_type inverse(vector_type diagonal) const
+    {
+        diagonal = diagonal.cwiseAbs();
+        const scalar_type largest = diagonal.size() > 0 ? diagonal.maxCoeff() : 0.0;
+        if (!(largest > 0.0) || !std::isfinite(largest))
+            return vector_type::Ones(diagonal.size());
+        return diagonal.cwiseMax(1e-8 * largest).cwiseInverse();
+    }
+};
+
+#endif // PRECONDITIONER_HPP
@@ -0,0 +1,530 @@
+#ifndef RBF_SURROGATE_HPP
+#define RBF_SURROGATE_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include "gradient_descent.hpp"
+#include "sobol.hpp"
+#include <algorithm> // For std::sort
+#include <fstream>
+#include <iomanip>   // For std::setprecision
+#include <numeric>   // For std::iota
+#include <optional>
+#include <random>
+#include <sstream>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Parameters for the RBF surrogate algorithm
+struct RBFSurrogateParams : public Params
+{
+    RBFSurrogateParams() = default;
+    // Constructor for RBFSurrogateParams
+    RBFSurrogateParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                       scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                       int_type max_iterations, scalar_type minimum_step,
+                       vector_type lower_bounds, vector_type upper_bounds, int_type batch_size,
+                       int_type initial_points, string_type archive)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          lower_bounds(lower_bounds), upper_bounds(upper_bounds), batch_size(batch_size),
+          initial_points(initial_points), archive(archive) {}
+    vector_type lower_bounds; // Lower corner of the box
+    vector_type upper_bounds; // Upper corner of the box
+    int_type batch_size;      // Points evaluated (in parallel) in every round
+    int_type initial_points;  // Points of the initial design (archive included), 0 for 2 (n + 1)
+    string_type archive;      // File of the evaluation archive (empty for none)
+};
+
+// Radial basis functions
+enum class RBFSurrogateType
+{
+    cubic,
+    thin_plate
+};
+
+/**
+ * \brief Radial basis function interpolant with a linear tail
+ *
+ * \f[
+ *     s(x) = \sum_i \lambda_i \varphi(\|x - x_i\|) + c_0 + c^T x,
+ * \f]
+ * with \f$ \varphi(r) = r^3 \f$ if `T == RBFSurrogateType::cubic` or
+ * \f$ \varphi(r) = r^2 \log r \f$ if `T == RBFSurrogateType::thin_plate`.
+ * The coefficients solve the symmetric system
+ * \f[
+ *     \begin{pmatrix} 0 & P^T \\ P & \Phi \end{pmatrix}
+ *     \begin{pmatrix} c \\ \lambda \end{pmatrix} =
+ *     \begin{pmatrix} 0 \\ f \end{pmatrix},
+ * \f]
+ * whose inverse is stored: a new point borders the matrix with a row and a
+ * column, and the inverse is updated with the Schur complement of the new
+ * diagonal entry in O(m^2) operations instead of being refactored.
+ */
+template <RBFSurrogateType T>
+class RBFInterpolant
+{
+public:
+    /*!
+     * Constructor
+     *
+     * @param points The first n + 1 points (affinely independent), as columns
+     * @param values The values of f at the points
+     */
+    RBFInterpolant(const matrix_type &points, const vector_type &values)
+        : centers(points), values(values)
+    {
+        const index_type n = points.rows(), m = points.cols();
+        matrix_type K = matrix_type::Zero(n + 1 + m, n + 1 + m);
+        for (index_type j = 0; j < m; ++j)
+        {
+            K(0, n + 1 + j) = K(n + 1 + j, 0) = 1.0;
+            K.block(1, n + 1 + j, n, 1) = points.col(j);
+            K.block(n + 1 + j, 1, 1, n) = points.col(j).transpose();
+            for (index_type i = 0; i < m; ++i)
+                K(n + 1 + i, n + 1 + j) = phi((points.col(i) - points.col(j)).norm());
+        }
+        inverse = K.fullPivLu().inverse();
+        coefficients = inverse.rightCols(m) * values;
+    }
+
+    /*!
+     * Add a point to the interpolant.
+     *
+     * @param x The point
+     * @param value The value of f at x
+     * @param min_distance The minimum distance from the points of the interpolant
+     * @return false if the point has not been added (too close to another point)
+     */
+    bool add(const vector_type &x, scalar_type value, scalar_type min_distance)
+    {
+        const index_type n = centers.rows(), m = centers.cols(), N = n + 1 + m;
+        if (!std::isfinite(value) || distance(x) < min_distance)
+            return false;
+
+        // New row and column of the matrix, and its Schur complement
+        vector_type b(N);
+        b(0) = 1.0;
+        b.segment(1, n) = x;
+        for (index_type j = 0; j < m; ++j)
+            b(n + 1 + j) = phi((centers.col(j) - x).norm());
+        const vector_type u = inverse * b;
+        const scalar_type s = phi(0.0) - b.dot(u);
+        if (!(std::abs(s) > 1e-14 * b.tail(m).cwiseAbs().maxCoeff()))
+            return false;
+
+        // Bordered inverse
+        inverse.conservativeResize(N + 1, N + 1);
+        inverse.topLeftCorner(N, N).noalias() += (u / s) * u.transpose();
+        inverse.col(N).head(N) = -u / s;
+        inverse.row(N).head(N) = -u.transpose() / s;
+        inverse(N, N) = 1.0 / s;
+
+        centers.conservativeResize(n, m + 1);
+        centers.col(m) = x;
+        values.conservativeResize(m + 1);
+        values(m) = value;
+        coefficients = inverse.rightCols(m + 1) * values;
+        return true;
+    }
+
+    // Value of the interpolant at x
+    scalar_type operator()(const vector_type &x) const
+    {
+        const index_type n = centers.rows();
+        scalar_type s = coefficients(0) + coefficients.segment(1, n).dot(x);
+        for (index_type j = 0; j < centers.cols(); ++j)
+            s += coefficients(n + 1 + j) * phi((x - centers.col(j)).norm());
+        return s;
+    }
+
+    // Gradient of the interpolant at x
+    vector_type gradient(const vector_type &x) const
+    {
+        const index_type n = centers.rows();
+        vector_type g = coefficients.segment(1, n);
+        for (index_type j = 0; j < centers.cols(); ++j)
+        {
+            const scalar_type r = (x - centers.col(j)).norm();
+            g += coefficients(n + 1 + j) * dphi_over_r(r) * (x - centers.col(j));
+        }
+        return g;
+    }
+
+    // Distance of x from the nearest point of the interpolant
+    scalar_type distance(const vector_type &x) const
+    {
+        return (centers.colwise() - x).colwise().norm().minCoeff();
+    }
+
+    // Number of points of the interpolant
+    index_type size() const { return centers.cols(); }
+
+private:
+    matrix_type centers;      // Points, as columns
+    vector_type values;       // Values of f at the points
+    matrix_type inverse;      // Inverse of the matrix of the system
+    vector_type coefficients; // c_0, c and lambda
+
+    static scalar_type phi(scalar_type r)
+    {
+        if constexpr (T == RBFSurrogateType::cubic)
+            return r * r * r;
+        else
+            return r > 0.0 ? r * r * std::log(r) : 0.0;
+    }
+
+    // phi'(r) / r
+    static scalar_type dphi_over_r(scalar_type r)
+    {
+        if constexpr (T == RBFSurrogateType::cubic)
+            return 3.0 * r;
+        else
+            return r > 0.0 ? 2.0 * std::log(r) + 1.0 : 0.0;
+    }
+};
+
+// State of a run of the RBF surrogate algorithm
+template <RBFSurrogateType T>
+struct RBFSurrogateState : public State
+{
+    RBFSurrogateState(const scalar_function &f) : local_f(f) {}
+    tbb::enumerable_thread_specific<scalar_function> local_f; // Each thread evaluates its own copy of f
+    std::vector<vector_type> points;                          // Evaluated points (archive included)
+    std::vector<scalar_type> values;                          // Values of f at the points
+    std::optional<RBFInterpolant<T>> surrogate;               // Interpolant of all the points
+    std::size_t best = 0;                                     // Best point
+    matrix_type x0, candidates;                               // Starting points and minima of the surrogate
+    vector_type predicted;                                    // Values of the surrogate at the minima
+    std::vector<index_type> order;                            // Order of the minima and of the starting points
+};
+
+// Surrogate optimization with a radial basis function interpolant
+// T is the radial basis function
+template <RBFSurrogateType T>
+class RBFSurrogate : public Method
+{
+
+public:
+    // Constructor with parameters
+    RBFSurrogate(const RBFSurrogateParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: the archive, the initial design and the interpolant of their points
+    std::unique_ptr<State> start() const override
+    {
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const vector_type width = upper - lower;
+        const index_type n = lower.size();
+        const index_type batch = std::max<int_type>(params.batch_size, 1);
+        const index_type initial = params.initial_points > 0 ? std::max<index_type>(params.initial_points, n + 1) : 2 * (n + 1);
+        auto state = std::make_unique<RBFSurrogateState<T>>(params.f);
+
+        // Evaluation archive and initial design
+        std::vector<vector_type> &points = state->points;
+        std::vector<scalar_type> &values = state->values;
+        load_archive(points, values);
+        SobolSequence sobol(n);
+        sobol.next(); // Skip the origin (a corner of the box)
+        std::vector<vector_type> design;
+        if (points.empty())
+            design.push_back(params.initial_condition.cwiseMax(lower).cwiseMin(upper));
+        while (points.size() + design.size() < static_cast<std::size_t>(initial))
+        {
+            const vector_type x = lower + sobol.next().cwiseProduct(width);
+            if (design.empty() || (x - design[0]).norm() >= params.tolerance_s) // Skip the initial condition
+                design.push_back(x);
+        }
+        evaluate(design, points, values, state->local_f);
+
+        // First n + 1 affinely independent points (more design points are added if needed)
+        std::vector<std::size_t> basis;
+        for (std::size_t i = 0; basis.size() < static_cast<std::size_t>(n + 1); ++i)
+        {
+            if (i == points.size())
+                evaluate({lower + sobol.next().cwiseProduct(width)}, points, values, state->local_f);
+            if (!std::isfinite(values[i]))
+                continue;
+            matrix_type P(basis.size() + 1, n + 1);
+            for (std::size_t j = 0; j <= basis.size(); ++j)
+            {
+                P(j, 0) = 1.0;
+                P.block(j, 1, 1, n) = points[j < basis.size() ? basis[j] : i].transpose();
+            }
+            if (P.fullPivLu().rank() == P.rows())
+                basis.push_back(i);
+        }
+        matrix_type basis_points(n, n + 1);
+        vector_type basis_values(n + 1);
+        for (index_type j = 0; j <= n; ++j)
+        {
+            basis_points.col(j) = points[basis[j]];
+            basis_values(j) = values[basis[j]];
+        }
+        RBFInterpolant<T> &surrogate = state->surrogate.emplace(basis_points, basis_values);
+        for (std::size_t i = 0; i < points.size(); ++i)
+            if (std::find(basis.begin(), basis.end(), i) == basis.end())
+                surrogate.add(points[i], values[i], params.tolerance_s);
+
+        state->best = std::min_element(values.begin(), values.end(), less) - values.begin();
+        const index_type starts = 2 * batch;
+        state->x0.resize(n, starts);
+        state->candidates.resize(n, starts);
+        state->predicted.resize(starts);
+        state->order.resize(starts);
+        state->x = points[state->best];
+        return state;
+    }
+
+    /**
+     * One round of the RBF surrogate algorithm (operator() loops over it
+     * until the run stops). The point of the state is the best point
+     * evaluated.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The evaluations of f are meant to be expensive: all of them are
+     * kept, in memory and (if `archive` is not empty) appended to the archive
+     * file, one line per point with its coordinates and the value of f. The
+     * points of the archive are loaded at the beginning of every run, so a
+     * run continues from the evaluations of the previous ones (the archive
+     * must be deleted when f changes).
+     *
+     * @note The initial design is the initial condition and the points of a
+     * Sobol sequence in the box, up to `initial_points` points with those of
+     * the archive. The interpolant is then fitted to all the points.
+     *
+     * @note In every round the surrogate is minimized with gradient descent
+     * (Armijo rule, with the exact gradient of the surrogate) from the best
+     * point and from 2 `batch_size` - 1 random points of the box, in
+     * parallel. The minima of the surrogate farther than `tolerance_s` from
+     * the evaluated points are proposed in order of predicted value; if they
+     * are fewer than `batch_size` the batch is completed with the random
+     * starting points (exploration). The batch is evaluated in parallel, each
+     * thread with its own copy of f, and added to the interpolant.
+     *
+     * @note The algorithm stops when the best proposal is predicted within
+     * `tolerance_r` and improves the best value by less than `tolerance_r`
+     * (residual criterion), or when all the minima of the surrogate have
+     * already been evaluated (step size criterion).
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<RBFSurrogateState<T> &>(base);
+        const vector_type &lower = params.lower_bounds;
+        const vector_type &upper = params.upper_bounds;
+        const vector_type width = upper - lower;
+        const index_type n = lower.size();
+        const index_type batch = std::max<int_type>(params.batch_size, 1);
+        const index_type starts = 2 * batch;
+        std::vector<vector_type> &points = state.points;
+        std::vector<scalar_type> &values = state.values;
+        RBFInterpolant<T> &surrogate = *state.surrogate;
+        std::size_t &best = state.best;
+        matrix_type &x0 = state.x0;
+        matrix_type &candidates = state.candidates;
+        vector_type &predicted = state.predicted;
+        std::vector<index_type> &order = state.order;
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Minimize the surrogate from the best point and from random points
+        std::mt19937 engine(iteration);
+        std::uniform_real_distribution<scalar_type> uniform(0.0, 1.0);
+        x0.col(0) = points[best];
+        for (index_type k = 1; k < starts; ++k)
+            for (index_type i = 0; i < n; ++i)
+                x0(i, k) = lower(i) + uniform(engine) * width(i);
+        {
+            // The surrogate is minimized in the variables y, x = center + half sin(y), so x stays in the box
+            const vector_type center = 0.5 * (lower + upper), half = 0.5 * width;
+            const auto x_of = [=](const vector_type &y) -> vector_type
+            { return center + half.cwiseProduct(y.array().sin().matrix()); };
+            SilentCout silent;
+            tbb::parallel_for(index_type(0), starts, [&](index_type k)
+                              {
+                                  const vector_type y0 = (x0.col(k) - center).cwiseQuotient(half.cwiseMax(1e-300)).cwiseMax(-1.0).cwiseMin(1.0).array().asin().matrix();
+                                  const GradientDescentParams surrogate_params(
+                                      [&](const vector_type &y) { return surrogate(x_of(y)); },
+                                      [&](const vector_type &y) -> vector_type
+                                      { return half.cwiseProduct(y.array().cos().matrix()).cwiseProduct(surrogate.gradient(x_of(y))); },
+                                      y0, params.tolerance_r, params.tolerance_s, 1.0, 100, 1e-12, 1e-4, 0.0);
+                                  const GradientDescent<GradientDescentType::armijo> solver(surrogate_params);
+                                  candidates.col(k) = x_of(solver());
+                                  predicted(k) = surrogate(candidates.col(k)); });
+        }
+
+        // Batch: the distinct new minima of the surrogate, then the random points farthest from the evaluated ones
+        const scalar_type separation = 1e-2 * width.norm();
+        std::vector<vector_type> proposals;
+        const auto is_new = [&](const vector_type &x)
+        {
+            if (surrogate.distance(x) < params.tolerance_s)
+                return false;
+            for (const vector_type &y : proposals)
+                if ((x - y).norm() < separation)
+                    return false;
+            return true;
+        };
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](index_type a, index_type b)
+                  { return less(predicted(a), predicted(b)); });
+        for (index_type k : order)
+            if (static_cast<index_type>(proposals.size()) < batch && is_new(candidates.col(k)))
+                proposals.push_back(candidates.col(k));
+
+        // Check for convergence (all the minima of the surrogate have been evaluated)
+        if (proposals.empty())
+        {
+            state.converged("step size");
+            return;
+        }
+        const scalar_type first_predicted = surrogate(proposals[0]);
+
+        vector_type distances(starts);
+        for (index_type k = 0; k < starts; ++k)
+            distances(k) = surrogate.distance(x0.col(k));
+        std::sort(order.begin(), order.end(), [&](index_type a, index_type b)
+                  { return distances(a) > distances(b); });
+        for (index_type k : order)
+            if (static_cast<index_type>(proposals.size()) < batch && is_new(x0.col(k)))
+                proposals.push_back(x0.col(k));
+
+        // Evaluate the batch and update the surrogate
+        const std::size_t offset = points.size();
+        const scalar_type previous_best = values[best];
+        evaluate(proposals, points, values, state.local_f);
+        for (std::size_t i = offset; i < points.size(); ++i)
+        {
+            surrogate.add(points[i], values[i], params.tolerance_s);
+            if (less(values[i], values[best]))
+                best = i;
+        }
+        state.x = points[best];
+
+        // Check for convergence (prediction error and improvement)
+        if (std::abs(values[offset] - first_predicted) < params.tolerance_r && previous_best - values[best] < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_type get_lower_bounds() const { return params.lower_bounds; }
+    vector_type get_upper_bounds() const { return params.upper_bounds; }
+    int_type get_batch_size() const { return params.batch_size; }
+    int_type get_initial_points() const { return params.initial_points; }
+    string_type get_archive() const { return params.archive; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the radial basis function, the box, initial
+     * condition, tolerance_r, tolerance_s, initial step, maximum iterations
+     * (rounds), minimum step, batch size, initial points and archive.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the radial basis function at compile time
+        if constexpr (T == RBFSurrogateType::cubic)
+        {
+            std::cout << "Radial basis function: cubic" << std::endl;
+        }
+        else if constexpr (T == RBFSurrogateType::thin_plate)
+        {
+            std::cout << "Radial basis function: thin plate spline" << std::endl;
+        }
+        Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+        std::cout << "lower_bounds: " << params.lower_bounds.format(commaFormat) << std::endl;
+        std::cout << "upper_bounds: " << params.upper_bounds.format(commaFormat) << std::endl;
+        Method::print();
+        std::cout << "batch_size: " << params.batch_size << std::endl;
+        std::cout << "initial_points: " << params.initial_points << std::endl;
+        std::cout << "archive: " << params.archive << std::endl;
+    };
+
+private:
+    RBFSurrogateParams params;
+
+    // Order of the values of f (the values that are not finite are the largest)
+    static bool less(scalar_type a, scalar_type b)
+    {
+        return std::isfinite(a) && (!std::isfinite(b) || a < b);
+    }
+
+    /**
+     * Evaluate f at some points in parallel and add them to the archive.
+     *
+     * @param xs The points
+     * @param points The points of the archive (updated)
+     * @param values The values of f at the points of the archive (updated)
+     * @param local_f The copies of f of the threads
+     */
+    void evaluate(const std::vector<vector_type> &xs, std::vector<vector_type> &points, std::vector<scalar_type> &values,
+                  tbb::enumerable_thread_specific<scalar_function> &local_f) const
+    {
+        std::vector<scalar_type> results(xs.size());
+        tbb::parallel_for(std::size_t(0), xs.size(), [&](std::size_t k)
+                          { results[k] = local_f.local()(xs[k]); });
+        points.insert(points.end(), xs.begin(), xs.end());
+        values.insert(values.end(), results.begin(), results.end());
+
+        if (params.archive.empty())
+            return;
+        std::ofstream file(params.archive, std::ios::app);
+        file << std::setprecision(17);
+        for (std::size_t k = 0; k < xs.size(); ++k)
+        {
+            for (index_type i = 0; i < xs[k].size(); ++i)
+                file << xs[k](i) << " ";
+            file << results[k] << "\n";
+        }
+    }
+
+    /**
+     * Load the points of the archive (those of the right dimension).
+     *
+     * @param points The points of the archive
+     * @param values The values of f at the points of the archive
+     */
+    void load_archive(std::vector<vector_type> &points, std::vector<scalar_type> &values) const
+    {
+        if (params.archive.empty())
+            return;
+        std::ifstream file(params.archive);
+        string_type line;
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            vector_type x(params.lower_bounds.size());
+            scalar_type value;
+            bool valid = true;
+            for (index_type i = 0; i < x.size(); ++i)
+                valid = valid && (stream >> x(i));
+            valid = valid && (stream >> value) && !(stream >> std::ws).good();
+            if (valid)
+            {
+                points.push_back(x);
+                values.push_back(value);
+            }
+        }
+    }
+};
+
+// Variants of the RBF surrogate optimization in the solver registry (rbf_surrogate_t)
+inline const bool rbf_surrogate_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<RBFSurrogate<RBFSurrogateType::cubic>, RBFSurrogateParams>("rbf_surrogate", "Cubic");
+    registry.add<RBFSurrogate<RBFSurrogateType::thin_plate>, RBFSurrogateParams>("rbf_surrogate", "Thin plate");
+    return true;
+}();
+
+#endif // RBF_SURROGATE_HPP
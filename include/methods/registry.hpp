@@ -0,0 +1,224 @@
+#ifndef REGISTRY_HPP
+#define REGISTRY_HPP
+
+#include "method.hpp"
+#include <algorithm>  // For std::sort
+#include <functional> // For std::function
+#include <memory>     // For std::unique_ptr
+#include <tuple>      // For std::tie
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+class GetPot; // Data file of the drivers (read in src/readnew.cpp)
+
+/**
+ * @brief Copies the parameters of a method and lets the caller modify the copy.
+ *
+ * @param params The parameters of the method (of the derived type).
+ * @param adjust The modification (nothing if empty).
+ * @return The modified copy.
+ */
+template <typename P>
+P adjusted(const P &params, const std::function<void(Params &)> &adjust)
+{
+    P copy = params;
+    if (adjust)
+        adjust(copy);
+    return copy;
+}
+
+/**
+ * \brief Registry of the solvers, from the type of the parameters and the method strings to a factory
+ *
+ * Each header of a method registers its variants at static initialization
+ * (an inline variable after the class), under the name of the method in the
+ * data file and the values of its method strings (e.g. "heavy_ball",
+ * heavy_ball_t = "Exponential decay", heavy_ball_s = "Constant"). Methods
+ * with a single variant are registered with empty strings.
+ *
+ * The solver of a set of parameters is found with a single hash lookup on the
+ * dynamic type of the parameters and the two strings, so adding a method only
+ * needs its header, and the drivers that build a solver for every run (e.g.
+ * multi-start) do not walk a chain of casts and comparisons.
+ *
+ * The reading layer (src/readnew.cpp) describes every method: the reader of
+ * its parameters from the data file and the keys that select it and its
+ * variant. The main program runs the described methods in the order of their
+ * descriptions, so it has no list of its own.
+ */
+class SolverRegistry
+{
+public:
+    //! Modification of the copy of the parameters stored in the solver
+    using Adjust = std::function<void(Params &)>;
+
+    //! Builds a solver from the parameters (of the registered type)
+    using Factory = std::function<std::unique_ptr<Method>(const Params &, const Adjust &)>;
+
+    //! A registered variant, for the enumeration of the available methods
+    struct Entry
+    {
+        string_type method;   // Name of the method in the data file
+        string_type method_t; // Primary method type
+        string_type method_s; // Secondary strategy (empty if the method has none)
+    };
+
+    //! Reads the parameters of a method (of the described type) from the data file
+    using Reader = std::function<void(const GetPot &, Params &)>;
+
+    //! How a method is selected and configured in the data file
+    struct Description
+    {
+        string_type title{};     // Title printed before its runs
+        bool selected = false;   // True if the method runs when the data file does not select it
+        string_type key_t{};     // Key of the primary method type (empty if the method has a single variant)
+        string_type default_t{}; // Default primary method type
+        string_type key_s{};     // Key of the secondary strategy (empty if the method has none)
+        string_type default_s{}; // Default secondary strategy
+    };
+
+    //! A described method, for the drivers that run the methods selected in the data file
+    struct MethodInfo
+    {
+        Description description;                              // Selection and variant in the data file
+        std::function<std::unique_ptr<Params>()> make_params; // Default parameters of the method
+        Reader read;                                          // Reader of the parameters
+    };
+
+    //! The registry (constructed at its first use, so the order of the registrations does not matter)
+    static SolverRegistry &instance()
+    {
+        static SolverRegistry registry;
+        return registry;
+    }
+
+    /*!
+     * Registers a variant of a method
+     *
+     * @tparam M The solver
+     * @tparam P The parameters of the solver
+     * @param method The name of the method in the data file
+     * @param method_t The primary method type
+     * @param method_s The secondary strategy (empty if the method has none)
+     */
+    template <typename M, typename P>
+    void add(const string_type &method, const string_type &method_t = "", const string_type &method_s = "")
+    {
+        factories[{typeid(P), method_t, method_s}] = [](const Params &params, const Adjust &adjust)
+        { return std::make_unique<M>(adjusted(static_cast<const P &>(params), adjust)); };
+        names.emplace(typeid(P), method);
+        entries.push_back({method, method_t, method_s});
+    }
+
+    /*!
+     * Builds the solver of the parameters and the method strings
+     *
+     * @param params The parameters of the method
+     * @param method_t The primary method type
+     * @param method_s The secondary strategy
+     * @param adjust A modification of the copy of the parameters stored in the solver (nothing if empty)
+     * @return The solver, or nullptr if the variant is not registered
+     */
+    std::unique_ptr<Method> make(const Params &params, const string_type &method_t, const string_type &method_s,
+                                 const Adjust &adjust = nullptr) const
+    {
+        const auto factory = factories.find({typeid(params), method_t, method_s});
+        if (factory == factories.end())
+            return nullptr;
+        return factory->second(params, adjust);
+    }
+
+    /*!
+     * Describes a method of the data file
+     *
+     * @tparam P The parameters of the method
+     * @param method The name of the method in the data file
+     * @param description The keys that select the method and its variant
+     * @param reader The reader of the parameters (called on a P)
+     */
+    template <typename P>
+    void describe(const string_type &method, const Description &description, const Reader &reader)
+    {
+        if (infos.find(method) == infos.end())
+            order.push_back(method);
+        infos[method] = {description, []
+                         { return std::unique_ptr<Params>(std::make_unique<P>()); }, reader};
+        readers[typeid(P)] = reader;
+    }
+
+    //! The described methods, in the order of their descriptions
+    const std::vector<string_type> &methods() const { return order; }
+
+    //! Description of a method (nullptr if the method is not described)
+    const MethodInfo *described(const string_type &method) const
+    {
+        const auto info = infos.find(method);
+        return info == infos.end() ? nullptr : &info->second;
+    }
+
+    /*!
+     * Reads the parameters of a described method from the data file
+     *
+     * @param datafile The data file
+     * @param params The parameters (of a described type)
+     * @return False if the type of the parameters has no reader
+     */
+    bool read(const GetPot &datafile, Params &params) const
+    {
+        const auto reader = readers.find(typeid(params));
+        if (reader == readers.end())
+            return false;
+        reader->second(datafile, params);
+        return true;
+    }
+
+    //! Name of the method of the parameters (empty if it is not registered)
+    string_type name(const Params &params) const
+    {
+        const auto name = names.find(typeid(params));
+        return name == names.end() ? string_type() : name->second;
+    }
+
+    //! The registered variants, sorted by method and method strings (for the list of the methods)
+    std::vector<Entry> available() const
+    {
+        std::vector<Entry> sorted = entries;
+        std::sort(sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b)
+                  { return std::tie(a.method, a.method_t, a.method_s) < std::tie(b.method, b.method_t, b.method_s); });
+        return sorted;
+    }
+
+private:
+    SolverRegistry() = default;
+
+    // Dynamic type of the parameters and the two method strings
+    struct Key
+    {
+        std::type_index params;
+        string_type method_t;
+        string_type method_s;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            std::size_t seed = key.params.hash_code();
+            for (const string_type *s : {&key.method_t, &key.method_s})
+                seed ^= std::hash<string_type>{}(*s) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    std::unordered_map<Key, Factory, KeyHash> factories;  // Factory of each variant
+    std::unordered_map<std::type_index, string_type> names; // Name of the method of each type of parameters
+    std::vector<Entry> entries;                             // Registered variants, in the order of registration
+    std::unordered_map<string_type, MethodInfo> infos;      // Description of each method
+    std::vector<string_type> order;                         // Described methods, in the order of description
+    std::unordered_map<std::type_index, Reader> readers;    // Reader of each type of parameters
+};
+
+#endif // REGISTRY_HPP
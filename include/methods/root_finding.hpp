@@ -0,0 +1,349 @@
+#ifndef ROOT_FINDING_HPP
+#define ROOT_FINDING_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+
+// Parameters for the nonlinear equation solvers
+struct RootFindingParams : public Params
+{
+    RootFindingParams() = default;
+    // Constructor for RootFindingParams
+    RootFindingParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                      scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                      int_type max_iterations, scalar_type minimum_step,
+                      vector_function system, scalar_type h,
+                      int_type krylov_dimension, int_type broyden_memory = 20)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          system(system), h(h), krylov_dimension(krylov_dimension),
+          broyden_memory(broyden_memory) {}
+    vector_function system;        // System F(x) = 0 to be solved
+    scalar_type h;                 // Step for the directional differences
+    int_type krylov_dimension;     // Maximum dimension of the Krylov subspace of GMRES
+    int_type broyden_memory = 20;  // Maximum number of rank-one corrections stored by Broyden's method
+};
+
+// Solver types
+enum class RootFindingType
+{
+    broyden,
+    newton_krylov
+};
+
+// State of a run of a nonlinear equation solver
+struct RootFindingState : public State
+{
+    vector_type F;        // Value of the system at the current point
+    scalar_type gamma;    // Scaling of the initial inverse Jacobian gamma I (Broyden's method)
+    matrix_type U;        // Columns u_i of the corrections u_i w_i^T of the inverse Jacobian (Broyden's method)
+    matrix_type W;        // Columns w_i of the corrections (Broyden's method)
+    index_type pairs = 0; // Number of stored corrections
+    scalar_type eta;      // Forcing term (inexact Newton method)
+};
+
+// Nonlinear equation solvers
+// T is the type of the solver
+template <RootFindingType T>
+class RootFinding : public Method
+{
+
+public:
+    // Constructor with parameters
+    RootFinding(const RootFindingParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<RootFindingState>();
+        state->x = params.initial_condition;
+        state->F = params.system(state->x);
+        if constexpr (T == RootFindingType::broyden)
+        {
+            const index_type memory = std::max<index_type>(1, params.broyden_memory);
+            state->U.resize(state->x.size(), memory);
+            state->W.resize(state->x.size(), memory);
+            restart(*state);
+        }
+        state->eta = 0.5;
+        return state;
+    }
+
+    /**
+     * One iteration of the nonlinear equation solver (operator() loops over
+     * it until the run stops).
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The algorithm stops when the norm of \f$ F(x) \f$ is less than
+     * `tolerance_r` or when the step size is less than `tolerance_s`.
+     *
+     * @note If `T == RootFindingType::broyden` the inverse of the Jacobian is
+     * approximated by a scaled identity \f$ H_0 = \gamma I \f$ corrected with
+     * the rank-one updates of Broyden's (good) method
+     * \f[
+     *     H_{k+1} = H_k + \frac{(s_k - H_k y_k) s_k^T H_k}{s_k^T H_k y_k}
+     * \f]
+     * stored as pairs of vectors (limited memory), so memory grows as
+     * O(n * broyden_memory) and an iteration costs O(n * broyden_memory)
+     * besides the evaluations of F. No Jacobian is evaluated: \f$ \gamma \f$
+     * comes from a directional difference of F, and the corrections restart
+     * when the memory is full (keeping the scaling \f$ s^T y / y^T y \f$ of
+     * the last step) or when the direction is not a descent direction for
+     * \f$ \|F\| \f$.
+     *
+     * @note If `T == RootFindingType::newton_krylov` the Newton system
+     * \f$ J p = -F \f$ is solved inexactly with GMRES, where the products
+     * \f$ J v \f$ are approximated by directional differences of F. The
+     * Jacobian is never formed, so memory grows as O(n * krylov_dimension).
+     *
+     * @note Both solvers halve the step until the norm of F decreases.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<RootFindingState &>(base);
+        vector_type &x = state.x;
+        vector_type &F = state.F;
+        scalar_type &eta = state.eta;
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Check for convergence (norm of F)
+        scalar_type residual = F.norm();
+        if (residual < params.tolerance_r)
+        {
+            state.converged("residual");
+            return;
+        }
+
+        // Compute the direction
+        vector_type p;
+        if constexpr (T == RootFindingType::broyden)
+        {
+            p = -inverse_jacobian(state, F);
+        }
+        else if constexpr (T == RootFindingType::newton_krylov)
+        {
+            p = gmres(x, F, eta * residual);
+        }
+
+        // Halve the step until the norm of F decreases
+        scalar_type alpha = params.initial_step;
+        vector_type F_new = params.system(x + alpha * p);
+        while (alpha > params.minimum_step && F_new.norm() >= (1.0 - 1e-4 * alpha) * residual)
+        {
+            alpha *= 0.5;
+            F_new = params.system(x + alpha * p);
+        }
+
+        if constexpr (T == RootFindingType::broyden)
+        {
+            if (alpha <= params.minimum_step)
+            {
+                // The secant approximation is no longer reliable: restart from a scaled identity
+                restart(state);
+                ++state.iteration;
+                return;
+            }
+            // Rank-one update of the inverse Jacobian
+            const vector_type s = alpha * p;
+            const vector_type y = F_new - F;
+            if (state.pairs == state.U.cols())
+            {
+                // Memory full: restart the corrections, with the scaling of the last step
+                const scalar_type gamma = s.dot(y) / y.squaredNorm();
+                if (std::isfinite(gamma) && gamma != 0.0)
+                    state.gamma = gamma;
+                state.pairs = 0;
+            }
+            const vector_type Hy = inverse_jacobian(state, y);
+            const scalar_type denominator = s.dot(Hy);
+            if (std::abs(denominator) > std::numeric_limits<scalar_type>::epsilon() * s.norm() * Hy.norm())
+            {
+                state.W.col(state.pairs) = inverse_jacobian_transpose(state, s);
+                state.U.col(state.pairs) = (s - Hy) / denominator;
+                ++state.pairs;
+            }
+        }
+        else if constexpr (T == RootFindingType::newton_krylov)
+        {
+            // Eisenstat-Walker forcing term
+            eta = std::min(0.9, 0.9 * F_new.squaredNorm() / F.squaredNorm());
+        }
+
+        // Update the current point
+        x = x + alpha * p;
+        F = F_new;
+
+        // Check for convergence (step size)
+        scalar_type step_size = alpha * p.norm();
+        if (step_size < params.tolerance_s)
+        {
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    vector_function get_system() const { return params.system; }
+    scalar_type get_h() const { return params.h; }
+    int_type get_broyden_memory() const { return params.broyden_memory; }
+    int_type get_krylov_dimension() const { return params.krylov_dimension; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the solver type, initial condition, tolerance_r,
+     * tolerance_s, initial step, maximum iterations, minimum step, h and the
+     * number of stored corrections (Broyden) or the dimension of the Krylov
+     * subspace (Newton-Krylov).
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the solver at compile time
+        if constexpr (T == RootFindingType::broyden)
+        {
+            std::cout << "Solver type: Broyden (limited-memory rank-one updates of the inverse jacobian)" << std::endl;
+        }
+        else if constexpr (T == RootFindingType::newton_krylov)
+        {
+            std::cout << "Solver type: Jacobian-free Newton-Krylov (GMRES)" << std::endl;
+        }
+        Method::print();
+        std::cout << "h: " << params.h << std::endl;
+        if constexpr (T == RootFindingType::broyden)
+        {
+            std::cout << "broyden_memory: " << params.broyden_memory << std::endl;
+        }
+        else if constexpr (T == RootFindingType::newton_krylov)
+        {
+            std::cout << "krylov_dimension: " << params.krylov_dimension << std::endl;
+        }
+    };
+
+private:
+    RootFindingParams params;
+
+    // Product of the approximate inverse Jacobian H = gamma I + sum_i u_i w_i^T with v
+    static vector_type inverse_jacobian(const RootFindingState &state, const vector_type &v)
+    {
+        return state.gamma * v + state.U.leftCols(state.pairs) * (state.W.leftCols(state.pairs).transpose() * v);
+    }
+
+    // Product of the transpose of H with v
+    static vector_type inverse_jacobian_transpose(const RootFindingState &state, const vector_type &v)
+    {
+        return state.gamma * v + state.W.leftCols(state.pairs) * (state.U.leftCols(state.pairs).transpose() * v);
+    }
+
+    /**
+     * Restart the approximate inverse Jacobian from \f$ \gamma I \f$, without
+     * corrections. With \f$ v = F / \|F\| \f$ and the directional difference
+     * \f$ J v \approx (F(x + \epsilon v) - F(x)) / \epsilon \f$ (one
+     * evaluation of F), \f$ \gamma = v^T J v / \|J v\|^2 \f$ is the scaling
+     * that best maps \f$ J v \f$ back to \f$ v \f$ (1 if F or J v vanish).
+     *
+     * @param state The state of the run
+     */
+    void restart(RootFindingState &state) const
+    {
+        state.pairs = 0;
+        state.gamma = 1.0;
+        const scalar_type norm = state.F.norm();
+        if (!(norm > 0.0))
+            return;
+        const vector_type v = state.F / norm;
+        const scalar_type epsilon = params.h * (1.0 + state.x.norm());
+        const vector_type Jv = (params.system(state.x + epsilon * v) - state.F) / epsilon;
+        const scalar_type JvJv = Jv.squaredNorm();
+        const scalar_type gamma = v.dot(Jv) / JvJv;
+        if (JvJv > 0.0 && std::isfinite(gamma) && gamma != 0.0)
+            state.gamma = gamma;
+    }
+
+    /**
+     * Solve \f$ J(x) p = -F(x) \f$ with GMRES (one cycle, no restart).
+     *
+     * The Jacobian-vector products are approximated by forward differences
+     * \f$ J v \approx (F(x + \epsilon v) - F(x)) / \epsilon \f$, with
+     * \f$ \epsilon = h (1 + \|x\|) \f$ (the basis vectors v have unit norm).
+     *
+     * @param x The current point
+     * @param F The value of the system at x
+     * @param tolerance The tolerance on the norm of the linear residual
+     * @return The (inexact) Newton direction
+     */
+    vector_type gmres(const vector_type &x, const vector_type &F, scalar_type tolerance) const
+    {
+        const index_type n = x.size();
+        const index_type m = std::max<index_type>(1, std::min<index_type>(params.krylov_dimension, n));
+        const scalar_type beta = F.norm();
+
+        matrix_type V(n, m + 1);                       // Orthonormal basis of the Krylov subspace
+        matrix_type R = matrix_type::Zero(m + 1, m);   // Hessenberg matrix, reduced to triangular
+        vector_type c(m), s(m);                        // Givens rotations
+        vector_type g = vector_type::Zero(m + 1);      // Rotated right hand side
+        V.col(0) = -F / beta;
+        g(0) = beta;
+
+        index_type k = 0;
+        while (k < m)
+        {
+            // Directional difference
+            vector_type v = V.col(k);
+            const scalar_type epsilon = params.h * (1.0 + x.norm());
+            vector_type w = (params.system(x + epsilon * v) - F) / epsilon;
+
+            // Modified Gram-Schmidt
+            for (index_type i = 0; i <= k; ++i)
+            {
+                R(i, k) = w.dot(V.col(i));
+                w -= R(i, k) * V.col(i);
+            }
+            R(k + 1, k) = w.norm();
+
+            // Apply the previous rotations and compute the new one
+            for (index_type i = 0; i < k; ++i)
+            {
+                const scalar_type temp = c(i) * R(i, k) + s(i) * R(i + 1, k);
+                R(i + 1, k) = -s(i) * R(i, k) + c(i) * R(i + 1, k);
+                R(i, k) = temp;
+            }
+            const scalar_type rho = std::hypot(R(k, k), R(k + 1, k));
+            c(k) = R(k, k) / rho;
+            s(k) = R(k + 1, k) / rho;
+            R(k, k) = rho;
+            R(k + 1, k) = 0.0;
+            g(k + 1) = -s(k) * g(k);
+            g(k) = c(k) * g(k);
+
+            const bool breakdown = w.norm() <= std::numeric_limits<scalar_type>::epsilon() * beta;
+            if (!breakdown)
+                V.col(k + 1) = w / w.norm();
+            ++k;
+            if (breakdown || std::abs(g(k)) < tolerance)
+                break;
+        }
+
+        // Solve the triangular system and build the direction
+        vector_type y = R.topLeftCorner(k, k).template triangularView<Eigen::Upper>().solve(g.head(k));
+        return V.leftCols(k) * y;
+    }
+};
+
+// Variants of the root finding methods in the solver registry (root_finding_t)
+inline const bool root_finding_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<RootFinding<RootFindingType::broyden>, RootFindingParams>("root_finding", "Broyden");
+    registry.add<RootFinding<RootFindingType::newton_krylov>, RootFindingParams>("root_finding", "Newton-Krylov");
+    return true;
+}();
+
+#endif // ROOT_FINDING_HPP
@@ -0,0 +1,586 @@
+#ifndef TRUST_REGION_DFO_HPP
+#define TRUST_REGION_DFO_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+// Parameters for the derivative-free trust region algorithm
+struct TrustRegionDFOParams : public Params
+{
+    TrustRegionDFOParams() = default;
+    // Constructor for TrustRegionDFOParams
+    TrustRegionDFOParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                         scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                         int_type max_iterations, scalar_type minimum_step,
+                         int_type interpolation_points)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          interpolation_points(interpolation_points) {}
+    int_type interpolation_points; // Number m of interpolation points (between n+2 and (n+1)(n+2)/2)
+};
+
+// Quadratic model Q(x) = c + g^T (x - base) + 1/2 (x - base)^T G (x - base)
+struct QuadraticModel
+{
+    vector_type base; // Point around which the model is written
+    scalar_type c;    // Value at the base point
+    vector_type g;    // Gradient at the base point
+    matrix_type G;    // Hessian
+
+    // Value of the model at x
+    scalar_type value(const vector_type &x) const
+    {
+        const vector_type d = x - base;
+        return c + g.dot(d) + 0.5 * d.dot(G * d);
+    }
+
+    // Write the model around a new base point
+    void shift(const vector_type &new_base)
+    {
+        c = value(new_base);
+        g += G * (new_base - base);
+        base = new_base;
+    }
+};
+
+// State of a run of the derivative-free trust region algorithm
+struct TrustRegionDFOState : public State
+{
+    TrustRegionDFOState(const scalar_function &f) : local_f(f) {}
+    tbb::enumerable_thread_specific<scalar_function> local_f; // Each thread evaluates its own copy of f
+    scalar_type delta;                                        // Trust region radius
+    matrix_type Y;                                            // Interpolation points (columns)
+    vector_type F;                                            // Values of f at the interpolation points
+    QuadraticModel model;                                     // Quadratic model of f
+    vector_type kkt_base;                                     // Base point of the KKT matrix of the points
+    matrix_type H;                                            // Inverse of the KKT matrix of the points
+    bool fresh = true;                                        // True if the interpolation points have just been reset
+};
+
+// Derivative-free trust region algorithm based on quadratic interpolation
+// (in the spirit of Powell's NEWUOA)
+class TrustRegionDFO : public Method
+{
+
+public:
+    // Constructor with parameters
+    TrustRegionDFO(const TrustRegionDFOParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run: the interpolation points around the initial condition and their model
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<TrustRegionDFOState>(params.f);
+        const vector_type &x0 = params.initial_condition;
+        const index_type n = x0.size();
+        const index_type m = std::clamp<index_type>(params.interpolation_points, n + 2, (n + 1) * (n + 2) / 2);
+        state->delta = params.initial_step;
+
+        // Initial interpolation points and model
+        state->Y = initial_points(x0, state->delta, m);
+        state->F.resize(m);
+        tbb::parallel_for(index_type(0), m, [&](index_type k)
+                          { state->F(k) = state->local_f.local()(state->Y.col(k)); });
+        state->model = QuadraticModel{x0, 0.0, vector_type::Zero(n), matrix_type::Zero(n, n)};
+        state->kkt_base = x0;
+        state->H = inverse_kkt(state->Y, state->kkt_base);
+        update_model(*state);
+        state->x = x0;
+        return state;
+    }
+
+    /**
+     * One iteration of the derivative-free trust region algorithm
+     * (operator() loops over it until the run stops). The point of the state
+     * is the best interpolation point.
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note The algorithm keeps m interpolation points and a quadratic model
+     * of f that interpolates them. At every iteration the model is minimized
+     * in the trust region (truncated conjugate gradient) and f is evaluated
+     * only at the new point, which replaces the interpolation point with the
+     * largest (distance weighted) Lagrange function. The model is then
+     * corrected by the quadratic D that interpolates the new residuals and
+     * has the minimum Frobenius norm of its Hessian, obtained from the KKT
+     * system
+     * \f[
+     *     \begin{bmatrix} A & X^T \\ X & 0 \end{bmatrix}
+     *     \begin{bmatrix} \lambda \\ c \\ g \end{bmatrix}
+     *     = \begin{bmatrix} f(y_j) - Q(y_j) \\ 0 \end{bmatrix},
+     *     \quad A_{ij} = \frac{1}{2} \left( (y_i - x_b)^T (y_j - x_b) \right)^2
+     * \f]
+     * with \f$ \nabla^2 D = \sum_j \lambda_j (y_j - x_b)(y_j - x_b)^T \f$.
+     * The inverse H of the KKT matrix is kept, and replacing one point
+     * changes one row and one column of the matrix, so H is corrected with
+     * Powell's update (NEWUOA) in O(m^2) operations instead of a new
+     * factorization. It is computed again only when the points are reset,
+     * when the best point moves far from the base point of the matrix
+     * (\f$ \|x_{opt} - x_b\|^2 > 10 \Delta^2 \f$) or when the update is
+     * ill-conditioned.
+     *
+     * @note When the model predicts badly, the radius is halved and the
+     * interpolation points too far from the best one are replaced by points
+     * that improve the geometry of the set, evaluated in parallel.
+     *
+     * @note The radius is updated as in NEWUOA, so it also shrinks when the
+     * steps are much shorter than the radius.
+     *
+     * @note The algorithm stops when the norm of the gradient of the model is
+     * less than `tolerance_r` or when the trust region radius (which starts
+     * from `initial_step`) is less than `tolerance_s`. Since the updated model
+     * can be inaccurate, both criteria are checked again after resetting the
+     * interpolation points around the best one (m - 1 evaluations in
+     * parallel); the same is done when a short step decreases f much more
+     * than predicted.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<TrustRegionDFOState &>(base);
+        matrix_type &Y = state.Y;
+        vector_type &F = state.F;
+        QuadraticModel &model = state.model;
+        scalar_type &delta = state.delta;
+        const index_type m = Y.cols();
+
+        index_type best;
+        F.minCoeff(&best);
+        const vector_type x_opt = Y.col(best);
+        state.x = x_opt;
+        if (state.iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        // Move the base point of the KKT matrix, whose entries grow as the fourth power of the distances
+        if ((x_opt - state.kkt_base).squaredNorm() > 10.0 * delta * delta)
+        {
+            state.kkt_base = x_opt;
+            state.H = inverse_kkt(Y, state.kkt_base);
+        }
+
+        // Check for convergence (norm of the gradient of the model)
+        scalar_type residual = model.g.norm();
+        if (residual < params.tolerance_r)
+        {
+            if (state.fresh)
+            {
+                state.converged("residual");
+                return;
+            }
+            // The updated model may be inaccurate: check again with fresh interpolation points
+            rebuild(state);
+            ++state.iteration;
+            return;
+        }
+        const bool was_fresh = state.fresh;
+        state.fresh = false;
+
+        // Minimize the model in the trust region and evaluate f at the new point
+        const vector_type s = trust_region_step(model, delta);
+        const vector_type x_new = x_opt + s;
+        const scalar_type f_new = state.local_f.local()(x_new);
+        const scalar_type predicted = model.c - model.value(x_new);
+        const scalar_type ratio = predicted > 0.0 ? (F(best) - f_new) / predicted : -1.0;
+
+        // Replace the point with the largest weighted Lagrange function
+        const vector_type center = f_new < F(best) ? x_new : x_opt;
+        const vector_type lagrange = lagrange_values(x_new, Y, state.kkt_base, state.H);
+        vector_type candidates = lagrange.cwiseAbs();
+        if (f_new >= F(best))
+            candidates(best) = 0.0;
+        // Points with a small Lagrange function would make the interpolation degenerate
+        const scalar_type threshold = 1e-2 * candidates.maxCoeff();
+        index_type t = -1;
+        scalar_type largest = -1.0;
+        for (index_type j = 0; j < m; ++j)
+        {
+            if (candidates(j) < threshold || (j == best && f_new >= F(best)))
+                continue;
+            const scalar_type weight = std::max(1.0, (Y.col(j) - center).squaredNorm() / (delta * delta));
+            if (candidates(j) * weight > largest)
+            {
+                largest = candidates(j) * weight;
+                t = j;
+            }
+        }
+        if (t < 0)
+        {
+            // No valid Lagrange value (e.g. singular KKT matrix): reset the interpolation points
+            rebuild(state);
+            ++state.iteration;
+            return;
+        }
+        replace_point(state, t, x_new);
+        F(t) = f_new;
+        update_model(state);
+
+        // A short step that decreases f much more than predicted means
+        // that the gradient of the model is wrong
+        if (!was_fresh && ratio > 2.0 && s.norm() < 0.1 * delta)
+        {
+            rebuild(state);
+            ++state.iteration;
+            return;
+        }
+
+        // Update the trust region radius
+        if (ratio < 0.1)
+        {
+            delta *= 0.5;
+            improve_geometry(state);
+        }
+        else if (ratio <= 0.7)
+        {
+            delta = std::max(0.5 * delta, s.norm());
+        }
+        else
+        {
+            delta = std::max(0.5 * delta, 2.0 * s.norm());
+        }
+
+        // Check for convergence (trust region radius)
+        if (delta < params.tolerance_s)
+        {
+            if (!was_fresh)
+            {
+                // Check again with fresh interpolation points
+                rebuild(state);
+                ++state.iteration;
+                return;
+            }
+            F.minCoeff(&best);
+            state.x = Y.col(best);
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    int_type get_interpolation_points() const { return params.interpolation_points; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: initial condition, tolerance_r, tolerance_s,
+     * initial step (initial trust region radius), maximum iterations,
+     * minimum step and the number of interpolation points.
+     */
+    void print() const override
+    {
+        std::cout << "Model: quadratic interpolation with minimum Frobenius norm updates" << std::endl;
+        Method::print();
+        std::cout << "interpolation_points: " << params.interpolation_points << std::endl;
+    };
+
+private:
+    TrustRegionDFOParams params;
+
+    /**
+     * Reset the interpolation points around the best point (the old Hessian
+     * is kept, the new model is its minimum Frobenius norm correction).
+     *
+     * @param state The state of the run
+     */
+    void rebuild(TrustRegionDFOState &state) const
+    {
+        const index_type m = state.Y.cols();
+        index_type best;
+        state.F.minCoeff(&best);
+        const vector_type x_opt = state.Y.col(best);
+        const scalar_type f_opt = state.F(best);
+        state.Y = initial_points(x_opt, state.delta, m);
+        state.F(0) = f_opt;
+        tbb::parallel_for(index_type(1), m, [&](index_type k)
+                          { state.F(k) = state.local_f.local()(state.Y.col(k)); });
+        state.kkt_base = x_opt;
+        state.H = inverse_kkt(state.Y, state.kkt_base);
+        update_model(state);
+        state.fresh = true;
+    }
+
+    /**
+     * Interpolation points around a center: the center, center +- delta e_i
+     * and then center + delta (e_i + e_j).
+     *
+     * @param center The first interpolation point
+     * @param delta The distance of the points from the center
+     * @param m The number of points
+     * @return The points (columns)
+     */
+    matrix_type initial_points(const vector_type &center, scalar_type delta, index_type m) const
+    {
+        const index_type n = center.size();
+        matrix_type Y = center.replicate(1, m);
+        for (index_type k = 1; k < m; ++k)
+        {
+            if (k <= n)
+                Y(k - 1, k) += delta;
+            else if (k <= 2 * n)
+                Y(k - n - 1, k) -= delta;
+            else
+            {
+                // Pairs (i, j), i < j, in order
+                index_type p = k - 2 * n - 1, i = 0;
+                while (p >= n - 1 - i)
+                    p -= n - 1 - i++;
+                Y(i, k) += delta;
+                Y(i + 1 + p, k) += delta;
+            }
+        }
+        return Y;
+    }
+
+    /**
+     * Correct the model so that it interpolates f at the interpolation points.
+     *
+     * The model is moved to the best point, then the correction with the
+     * minimum Frobenius norm of the Hessian, computed with the inverse of the
+     * KKT matrix around its base point, is added.
+     *
+     * @param state The state of the run
+     */
+    void update_model(TrustRegionDFOState &state) const
+    {
+        const matrix_type &Y = state.Y;
+        const vector_type &F = state.F;
+        const vector_type &base = state.kkt_base;
+        QuadraticModel &model = state.model;
+        const index_type n = Y.rows();
+        const index_type m = Y.cols();
+        index_type best;
+        F.minCoeff(&best);
+        model.shift(Y.col(best));
+
+        vector_type rhs = vector_type::Zero(m + n + 1);
+        for (index_type j = 0; j < m; ++j)
+            rhs(j) = F(j) - model.value(Y.col(j));
+        const vector_type solution = state.H * rhs;
+
+        // Correction D(x) = c + g^T (x - base) + 1/2 (x - base)^T G_D (x - base), written around the base of the model
+        const matrix_type D = Y.colwise() - base;
+        const matrix_type G_D = D * solution.head(m).asDiagonal() * D.transpose();
+        const vector_type d = model.base - base;
+        const vector_type g_D = solution.tail(n) + G_D * d;
+        model.c += solution(m) + solution.tail(n).dot(d) + 0.5 * d.dot(G_D * d);
+        model.g += g_D;
+        model.G += G_D;
+    }
+
+    /**
+     * Column of the KKT matrix of a point x (without its diagonal entry).
+     *
+     * @param x The point
+     * @param Y The interpolation points (columns)
+     * @param base The base point of the KKT matrix
+     * @return The vector (1/2 ((y_j - base)^T (x - base))^2, 1, x - base)
+     */
+    vector_type kkt_column(const vector_type &x, const matrix_type &Y, const vector_type &base) const
+    {
+        const index_type n = Y.rows();
+        const index_type m = Y.cols();
+        const vector_type d = x - base;
+        vector_type w(m + n + 1);
+        w.head(m) = 0.5 * ((Y.colwise() - base).transpose() * d).array().square().matrix();
+        w(m) = 1.0;
+        w.tail(n) = d;
+        return w;
+    }
+
+    /**
+     * Inverse of the KKT matrix of the interpolation points.
+     *
+     * @param Y The interpolation points (columns)
+     * @param base The base point
+     * @return The inverse of the KKT matrix
+     */
+    matrix_type inverse_kkt(const matrix_type &Y, const vector_type &base) const
+    {
+        const index_type n = Y.rows();
+        const index_type m = Y.cols();
+        const matrix_type D = Y.colwise() - base;
+        const matrix_type inner = D.transpose() * D;
+        matrix_type W = matrix_type::Zero(m + n + 1, m + n + 1);
+        W.topLeftCorner(m, m) = 0.5 * inner.array().square().matrix();
+        W.block(0, m, m, 1).setOnes();
+        W.block(0, m + 1, m, n) = D.transpose();
+        W.block(m, 0, 1, m).setOnes();
+        W.block(m + 1, 0, n, m) = D;
+        return W.partialPivLu().inverse();
+    }
+
+    /**
+     * Replace the interpolation point t with x and update the inverse H of
+     * the KKT matrix with Powell's formula
+     * \f[
+     *     H_+ = H + \frac{1}{\sigma} \left[ \alpha (e_t - H w)(e_t - H w)^T
+     *         - \beta H e_t e_t^T H
+     *         + \tau \left( H e_t (e_t - H w)^T + (e_t - H w) e_t^T H \right) \right]
+     * \f]
+     * where w is the column of x in the KKT matrix, \f$ \alpha = e_t^T H e_t \f$,
+     * \f$ \beta = \frac{1}{2} \|x - x_b\|^4 - w^T H w \f$,
+     * \f$ \tau = e_t^T H w \f$ (the Lagrange function of t at x) and
+     * \f$ \sigma = \alpha \beta + \tau^2 \f$. If \f$ \sigma \f$ is too
+     * small the inverse is computed again.
+     *
+     * @param state The state of the run
+     * @param t The index of the replaced point
+     * @param x The new point
+     */
+    void replace_point(TrustRegionDFOState &state, index_type t, const vector_type &x) const
+    {
+        matrix_type &H = state.H;
+        const vector_type w = kkt_column(x, state.Y, state.kkt_base);
+        const vector_type Hw = H * w;
+        const vector_type He_t = H.col(t);
+        vector_type v = -Hw;
+        v(t) += 1.0;
+        const scalar_type alpha = He_t(t);
+        const scalar_type beta = 0.5 * std::pow((x - state.kkt_base).squaredNorm(), 2) - w.dot(Hw);
+        const scalar_type tau = Hw(t);
+        const scalar_type sigma = alpha * beta + tau * tau;
+
+        state.Y.col(t) = x;
+        if (!(std::abs(sigma) > 1e-10 * std::max(tau * tau, std::abs(alpha * beta))) || !std::isfinite(sigma))
+        {
+            H = inverse_kkt(state.Y, state.kkt_base);
+            return;
+        }
+        H += (alpha * v * v.transpose() - beta * He_t * He_t.transpose() +
+              tau * (He_t * v.transpose() + v * He_t.transpose())) /
+             sigma;
+    }
+
+    /**
+     * Values of the Lagrange functions of the interpolation points at x.
+     *
+     * @param x The point
+     * @param Y The interpolation points
+     * @param base The base point of the KKT matrix
+     * @param H The inverse of the KKT matrix
+     * @return The vector of the m Lagrange functions evaluated at x
+     */
+    vector_type lagrange_values(const vector_type &x, const matrix_type &Y, const vector_type &base,
+                                const matrix_type &H) const
+    {
+        const index_type m = Y.cols();
+        return (H * kkt_column(x, Y, base)).head(m);
+    }
+
+    /**
+     * Replace the interpolation points far from the best one.
+     *
+     * Every point farther than 2 delta from the best point is replaced by the
+     * point at distance delta (along a coordinate or towards the old point)
+     * where its Lagrange function is largest. The Lagrange functions depend
+     * only on the points, so the replacements are chosen one after the other
+     * without evaluating f (each replacement updates the inverse of the KKT
+     * matrix); the new points are then evaluated in parallel and the model is
+     * updated.
+     *
+     * @param state The state of the run
+     */
+    void improve_geometry(TrustRegionDFOState &state) const
+    {
+        matrix_type &Y = state.Y;
+        vector_type &F = state.F;
+        const scalar_type delta = state.delta;
+        const index_type n = Y.rows();
+        const index_type m = Y.cols();
+        index_type best;
+        F.minCoeff(&best);
+        const vector_type x_opt = Y.col(best);
+
+        std::vector<index_type> replaced;
+        for (index_type t = 0; t < m; ++t)
+        {
+            if (t == best || (Y.col(t) - x_opt).norm() <= 2.0 * delta)
+                continue;
+
+            // Candidate points
+            std::vector<vector_type> candidates;
+            for (index_type i = 0; i < n; ++i)
+            {
+                candidates.push_back(x_opt + delta * vector_type::Unit(n, i));
+                candidates.push_back(x_opt - delta * vector_type::Unit(n, i));
+            }
+            candidates.push_back(x_opt + delta * (Y.col(t) - x_opt).normalized());
+
+            scalar_type largest = 0.0;
+            vector_type chosen;
+            for (const vector_type &candidate : candidates)
+            {
+                const scalar_type value = std::abs(lagrange_values(candidate, Y, state.kkt_base, state.H)(t));
+                if (value > largest)
+                {
+                    largest = value;
+                    chosen = candidate;
+                }
+            }
+            if (largest > 0.0)
+            {
+                replaced.push_back(t);
+                replace_point(state, t, chosen);
+            }
+        }
+        if (replaced.empty())
+            return;
+
+        tbb::parallel_for(std::size_t(0), replaced.size(), [&](std::size_t k)
+                          { F(replaced[k]) = state.local_f.local()(Y.col(replaced[k])); });
+        update_model(state);
+    }
+
+    /**
+     * Approximate minimizer of the model in the ball of radius delta
+     * around the base point (Steihaug-Toint truncated conjugate gradient).
+     *
+     * @param model The quadratic model
+     * @param delta The trust region radius
+     * @return The step from the base point
+     */
+    vector_type trust_region_step(const QuadraticModel &model, scalar_type delta) const
+    {
+        const index_type n = model.g.size();
+        vector_type s = vector_type::Zero(n);
+        vector_type r = model.g;
+        vector_type d = -r;
+
+        // Distance along d from s to the boundary of the trust region
+        auto boundary = [&](const vector_type &s, const vector_type &d)
+        {
+            const scalar_type a = d.squaredNorm(), b = s.dot(d), c = s.squaredNorm() - delta * delta;
+            return (-b + std::sqrt(b * b - a * c)) / a;
+        };
+
+        for (index_type k = 0; k < n && r.norm() > 1e-12 * model.g.norm(); ++k)
+        {
+            const vector_type Gd = model.G * d;
+            const scalar_type curvature = d.dot(Gd);
+            if (curvature <= 0.0)
+                return s + boundary(s, d) * d;
+            const scalar_type alpha = r.squaredNorm() / curvature;
+            if ((s + alpha * d).norm() >= delta)
+                return s + boundary(s, d) * d;
+            s += alpha * d;
+            const vector_type r_new = r + alpha * Gd;
+            d = -r_new + (r_new.squaredNorm() / r.squaredNorm()) * d;
+            r = r_new;
+        }
+        return s;
+    }
+};
+
+// The derivative-free trust region method in the solver registry (there is only one variant)
+inline const bool trust_region_dfo_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<TrustRegionDFO, TrustRegionDFOParams>("trust_region_dfo");
+    return true;
+}();
+
+#endif // TRUST_REGION_DFO_HPP
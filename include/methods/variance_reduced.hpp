@@ -0,0 +1,257 @@
+#ifndef VARIANCE_REDUCED_HPP
+#define VARIANCE_REDUCED_HPP
+
+#include "method.hpp"
+#include "registry.hpp"
+#include "stochastic_objective.hpp"
+#include <tbb/parallel_for.h>
+
+// Parameters for the variance reduced stochastic methods
+struct VarianceReducedParams : public Params
+{
+    VarianceReducedParams() = default;
+    // Constructor for VarianceReducedParams
+    VarianceReducedParams(scalar_function f, vector_function df_grad_f, vector_type initial_condition,
+                          scalar_type tolerance_r, scalar_type tolerance_s, scalar_type initial_step,
+                          int_type max_iterations, scalar_type minimum_step,
+                          const StochasticObjective &objective, int_type batch_size)
+        : Params(f, df_grad_f, initial_condition, tolerance_r, tolerance_s,
+                 initial_step, max_iterations, minimum_step),
+          objective(objective), batch_size(batch_size) {}
+    StochasticObjective objective; // Objective f = (1/N) sum_i f_i (each copy of the parameters has its own)
+    int_type batch_size;           // Number of terms in each mini-batch
+};
+
+// Variance reduction techniques
+enum class VarianceReducedType
+{
+    svrg,
+    saga
+};
+
+// State of a run of a variance reduced method
+struct VarianceReducedState : public State
+{
+    std::vector<index_type> order; // Order of the terms, shuffled in place at every epoch
+    std::mt19937 engine;           // Random engine of the shuffles
+    vector_type snapshot;          // Snapshot (SVRG)
+    vector_type mu;                // Full gradient at the snapshot (SVRG)
+    matrix_type table;             // Table of the gradients of the terms (SAGA)
+    vector_type mean;              // Mean of the columns of the table (SAGA)
+    matrix_type batch_grads;       // New gradients of a mini-batch (SAGA)
+};
+
+// Variance reduced stochastic gradient algorithm
+// T is the variance reduction technique
+template <VarianceReducedType T>
+class VarianceReduced : public Method
+{
+
+public:
+    // Constructor with parameters
+    VarianceReduced(const VarianceReducedParams &params) : Method(params), params(params) {}
+
+    // Initial state of a run
+    std::unique_ptr<State> start() const override
+    {
+        auto state = std::make_unique<VarianceReducedState>();
+        const StochasticObjective &objective = params.objective;
+        const index_type N = objective.size();
+        state->x = params.initial_condition;
+        state->order.resize(N);
+        std::iota(state->order.begin(), state->order.end(), 0);
+        state->engine.seed(0);
+        if constexpr (T == VarianceReducedType::saga)
+        {
+            const vector_type &x = state->x;
+            matrix_type &table = state->table;
+            table.resize(x.size(), N);
+            tbb::parallel_for(index_type(0), N, [&](index_type i)
+                              { table.col(i) = objective.grad_term(x, i); });
+            state->mean = table.rowwise().mean();
+            state->batch_grads.resize(x.size(), std::clamp<index_type>(params.batch_size, 1, N));
+        }
+        return state;
+    }
+
+    /**
+     * One epoch of the variance reduced stochastic gradient algorithm
+     * (operator() loops over it until the run stops).
+     *
+     * @param base The state of the run, created by start
+     *
+     * @note Every iteration is an epoch: the terms are shuffled and visited in
+     * mini-batches B, and each mini-batch makes a step \f$ x \leftarrow x - \alpha v \f$
+     * with the constant step \f$ \alpha \f$ = `initial_step`.
+     *
+     * @note If `T == VarianceReducedType::svrg` the epoch starts from a
+     * snapshot \f$ \tilde{x} \f$ and its full gradient \f$ \tilde{\mu} \f$
+     * (a parallel reduction over all the terms), then
+     * \f[
+     *     v = \frac{1}{|B|} \sum_{i \in B} \left( \nabla f_i(x) - \nabla f_i(\tilde{x}) \right) + \tilde{\mu}
+     * \f]
+     * The norm of \f$ \tilde{\mu} \f$ is used for the residual criterion.
+     *
+     * @note If `T == VarianceReducedType::saga` the last gradient of every
+     * term is kept in a table (an n x N matrix, one contiguous column per
+     * term) together with the mean \f$ \bar{g} \f$ of its columns, then
+     * \f[
+     *     v = \frac{1}{|B|} \sum_{i \in B} \left( \nabla f_i(x) - g_i \right) + \bar{g}
+     * \f]
+     * and the columns of the batch are replaced by the new gradients. The
+     * norm of \f$ \bar{g} \f$ at the end of the epoch is used for the
+     * residual criterion.
+     *
+     * @note The step size criterion uses the distance covered in the epoch.
+     */
+    void step(State &base) const override
+    {
+        auto &state = static_cast<VarianceReducedState &>(base);
+        const StochasticObjective &objective = params.objective;
+        const index_type N = objective.size();
+        const index_type batch_size = std::clamp<index_type>(params.batch_size, 1, N);
+        vector_type &x = state.x;
+        const index_type n = x.size();
+        const scalar_type alpha = params.initial_step;
+        const index_type iteration = state.iteration;
+        if (iteration >= params.max_iterations)
+        {
+            state.not_converged();
+            return;
+        }
+
+        if constexpr (T == VarianceReducedType::svrg)
+        {
+            // Snapshot and full gradient
+            state.snapshot = x;
+            state.mu = objective.grad(state.snapshot);
+
+            // Check for convergence (norm of the gradient)
+            scalar_type residual = state.mu.norm();
+            if (residual < params.tolerance_r)
+            {
+                state.converged("residual");
+                return;
+            }
+        }
+
+        vector_type x_prev = x;
+        std::shuffle(state.order.begin(), state.order.end(), state.engine);
+        for (index_type first = 0; first < N; first += batch_size)
+        {
+            const index_type count = std::min(batch_size, N - first);
+            std::span<const index_type> batch(state.order.data() + first, count);
+
+            if constexpr (T == VarianceReducedType::svrg)
+            {
+                x -= alpha * (correction(x, state.snapshot, batch) + state.mu);
+            }
+            else if constexpr (T == VarianceReducedType::saga)
+            {
+                // New gradients of the batch
+                tbb::parallel_for(index_type(0), count, [&](index_type k)
+                                  { state.batch_grads.col(k) = objective.grad_term(x, batch[k]); });
+                vector_type difference = vector_type::Zero(n);
+                for (index_type k = 0; k < count; ++k)
+                {
+                    difference += state.batch_grads.col(k) - state.table.col(batch[k]);
+                    state.table.col(batch[k]) = state.batch_grads.col(k);
+                }
+                x -= alpha * (difference / count + state.mean);
+                state.mean += difference / N;
+            }
+        }
+
+        if constexpr (T == VarianceReducedType::saga)
+        {
+            // Check for convergence (norm of the gradient)
+            scalar_type residual = state.mean.norm();
+            if (residual < params.tolerance_r)
+            {
+                state.converged("residual");
+                return;
+            }
+        }
+
+        // Check for convergence (step size)
+        scalar_type step_size = (x - x_prev).norm();
+        if (step_size < params.tolerance_s)
+        {
+            state.converged("step size");
+            return;
+        }
+        ++state.iteration;
+    };
+
+    // Getters
+    const Params &get_params() const override { return params; }
+    const StochasticObjective &get_objective() const { return params.objective; }
+    int_type get_batch_size() const { return params.batch_size; }
+
+    /**
+     * Prints the parameters of this method.
+     *
+     * The parameters are: the variance reduction technique, the number of
+     * terms, initial condition, tolerance_r, tolerance_s, initial step
+     * (constant), maximum iterations (epochs), minimum step and batch size.
+     */
+    void print() const override
+    {
+        // Use constexpr if to select the variance reduction technique at compile time
+        if constexpr (T == VarianceReducedType::svrg)
+        {
+            std::cout << "Variance reduction: SVRG (full gradient at a snapshot every epoch)" << std::endl;
+        }
+        else if constexpr (T == VarianceReducedType::saga)
+        {
+            std::cout << "Variance reduction: SAGA (table of the gradients of the terms)" << std::endl;
+        }
+        std::cout << "terms: " << params.objective.size() << std::endl;
+        Method::print();
+        std::cout << "batch_size: " << params.batch_size << std::endl;
+    };
+
+private:
+    VarianceReducedParams params;
+
+    /**
+     * Mean over a mini-batch of grad f_i(x) - grad f_i(snapshot) (SVRG),
+     * computed with a parallel reduction.
+     *
+     * @param x The current point
+     * @param snapshot The snapshot of the epoch
+     * @param batch The indices of the terms in the mini-batch
+     * @return The variance reduction correction
+     */
+    vector_type correction(const vector_type &x, const vector_type &snapshot, std::span<const index_type> batch) const
+    {
+        const StochasticObjective &objective = params.objective;
+        const vector_type sum = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, batch.size()), vector_type(vector_type::Zero(x.size())),
+            [&](const tbb::blocked_range<std::size_t> &range, vector_type partial)
+            {
+                vector_type z = x;
+                vector_type z_snapshot = snapshot;
+                for (std::size_t k = range.begin(); k != range.end(); ++k)
+                {
+                    objective.add_grad_term(z, batch[k], partial);
+                    objective.add_grad_term(z_snapshot, batch[k], partial, -1.0);
+                }
+                return partial;
+            },
+            [](const vector_type &a, const vector_type &b) -> vector_type
+            { return a + b; });
+        return sum / batch.size();
+    }
+};
+
+// Variants of the variance reduced methods in the solver registry (variance_reduced_t)
+inline const bool variance_reduced_registered = []
+{
+    SolverRegistry &registry = SolverRegistry::instance();
+    registry.add<VarianceReduced<VarianceReducedType::svrg>, VarianceReducedParams>("variance_reduced", "SVRG");
+    registry.add<VarianceReduced<VarianceReducedType::saga>, VarianceReducedParams>("variance_reduced", "SAGA");
+    return true;
+}();
+
+#endif // VARIANCE_REDUCED_HPP
@@ -7,6 +7,67 @@
 #include <map>
 #include <mpParser.h>
 
+/**
+ * \brief Named parameters of muParserX expressions, bound by reference
+ *
+ * A parameter set is a handle: its copies share the same values. The
+ * interfaces created with a parameter set (and all their copies) bind the
+ * engine variables to these values, so a value changed with set() is used by
+ * the next evaluation of every expression, without parsing it again. The
+ * parameters have to be defined before the interfaces are created, later
+ * calls of set() only change their values.
+ */
+class Parameters
+{
+public:
+    Parameters() : values(std::make_shared<std::map<string_type, std::shared_ptr<mup::Value>>>()) {}
+
+    //! Defines a scalar parameter, or changes its value
+    void set(const string_type &name, scalar_type value)
+    {
+        auto &entry = (*values)[name];
+        if (!entry)
+            entry = std::make_shared<mup::Value>(value);
+        else
+            *entry = value;
+    }
+
+    //! Defines a vector parameter, or changes its value (also its size)
+    void set(const string_type &name, const vector_type &value)
+    {
+        mup::Value array(static_cast<int>(value.size()), 0.0);
+        for (index_type i = 0; i < value.size(); ++i)
+            array.At(i) = value(i);
+        auto &entry = (*values)[name];
+        if (!entry)
+            entry = std::make_shared<mup::Value>(array);
+        else
+            *entry = array;
+    }
+
+    //! True if the parameter is defined
+    bool contains(const string_type &name) const { return values->count(name) > 0; }
+
+    //! A parameter set with the same parameters, whose values are independent of these
+    Parameters clone() const
+    {
+        Parameters copy;
+        for (const auto &[name, value] : *values)
+            (*copy.values)[name] = std::make_shared<mup::Value>(*value);
+        return copy;
+    }
+
+    //! Defines the parameters as variables of a muParserX engine
+    void bind(mup::ParserX &parser) const
+    {
+        for (const auto &[name, value] : *values)
+            parser.DefineVar(name, mup::Variable(value.get()));
+    }
+
+private:
+    std::shared_ptr<std::map<string_type, std::shared_ptr<mup::Value>>> values;
+};
+
 // Adapted from muParserInterface inside pacs-examples repository (https://github.com/pacs-course/pacs-examples.git)
 // The class that will be used to parse functions
 class muParserXInterface
@@ -27,20 +88,21 @@ public:
     //! Constructor that takes a string containing muParserX expression
     muParserXInterface(const string_type expression, const unsigned N = 1) : muParserXInterface(N)
     {
-        try
-        {
-            My_e = expression;
-            M_parser.SetExpr(My_e.c_str());
-        }
-        catch (mup::ParserError &error)
-        {
-            std::cerr << "Muparsex error with code:" << error.GetCode()
-                      << std::endl;
-            std::cerr << "While processing expression: " << error.GetExpr()
-                      << std::endl;
-            std::cerr << "Error Message: " << error.GetMsg() << std::endl;
-            throw error;
-        }
+        parse(expression);
+    }
+
+    //! Constructor with named parameters in the expression
+    //!
+    //! The parameters are bound by reference and shared by all the copies of
+    //! the interface, so changing them (e.g. between the solves of a sweep)
+    //! changes the function evaluated by all of them, without parsing it again.
+    //! @param parameters the parameters of the expression
+    muParserXInterface(const string_type expression, const unsigned N, const Parameters &parameters)
+        : muParserXInterface(N)
+    {
+        M_parameters = parameters;
+        M_parameters.bind(M_parser);
+        parse(expression);
     }
 
     /*!
@@ -57,9 +119,11 @@ public:
      */
     muParserXInterface(muParserXInterface const &mpi)
         : My_e(mpi.My_e),
-          M_parser(mup::pckALL_NON_COMPLEX | mup::pckMATRIX), M_value{mpi.N, 0.0}, N(mpi.N)
+          M_parser(mup::pckALL_NON_COMPLEX | mup::pckMATRIX), M_value{mpi.N, 0.0}, N(mpi.N),
+          M_parameters(mpi.M_parameters)
     {
         M_parser.DefineVar("x", mup::Variable(&M_value));
+        M_parameters.bind(M_parser);
         M_parser.SetExpr(My_e.c_str());
     }
 
@@ -80,7 +144,9 @@ public:
             this->M_parser.ClearVar(); // clear the variables!
             this->M_value = mpi.M_value;
             this->N = mpi.N;
+            this->M_parameters = mpi.M_parameters;
             M_parser.DefineVar("x", mup::Variable(&M_value));
+            M_parameters.bind(M_parser);
             M_parser.SetExpr(My_e.c_str());
         }
         return *this;
@@ -156,6 +222,25 @@ public:
     }
 
 protected:
+    //! Sets the expression, reporting the errors of the parser
+    void parse(const string_type &expression)
+    {
+        try
+        {
+            My_e = expression;
+            M_parser.SetExpr(My_e.c_str());
+        }
+        catch (mup::ParserError &error)
+        {
+            std::cerr << "Muparsex error with code:" << error.GetCode()
+                      << std::endl;
+            std::cerr << "While processing expression: " << error.GetExpr()
+                      << std::endl;
+            std::cerr << "Error Message: " << error.GetMsg() << std::endl;
+            throw error;
+        }
+    }
+
     // a copy of the muparserX expression, used for the copy operations
     string_type My_e;
     // The muparseX engine
@@ -163,6 +248,8 @@ protected:
     // The muparserX value used to set the variables in the engine
     mutable mup::Value M_value;
     mutable unsigned N;
+    // The named parameters of the expression, shared by all the copies
+    Parameters M_parameters;
 };
 
 /**
@@ -184,6 +271,10 @@ public:
      * @param N The size of the vector returned by the expression
      */
     muParserXVectorInterface(const string_type expression, const unsigned N = 1) : muParserXInterface(expression, N) {}
+
+    //! Constructor with named parameters in the expression (see muParserXInterface)
+    muParserXVectorInterface(const string_type expression, const unsigned N, const Parameters &parameters)
+        : muParserXInterface(expression, N, parameters) {}
     
     /*!
      * Since the expression may evaluate to a matrix, the result is
@@ -219,6 +310,10 @@ public:
      */
     muParserXScalarInterface(const string_type expression, const unsigned N = 1) : muParserXVectorInterface(expression, N) {}
 
+    //! Constructor with named parameters in the expression (see muParserXInterface)
+    muParserXScalarInterface(const string_type expression, const unsigned N, const Parameters &parameters)
+        : muParserXVectorInterface(expression, N, parameters) {}
+
     /*!
      * Evaluate the expression and return the first element of the result.
      *
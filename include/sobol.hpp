@@ -0,0 +1,113 @@
+#ifndef SOBOL_HPP
+#define SOBOL_HPP
+
+#include <Math>
+#include <array>
+#include <cstdint>
+#include <random>
+
+/**
+ * \brief Sobol low-discrepancy sequence in the unit hypercube
+ *
+ * The points are generated with the Gray code construction of Antonov and
+ * Saleev (one XOR per component), with the direction numbers of Joe and Kuo
+ * (new-joe-kuo-6.21201) for the first 16 dimensions. Further components, if
+ * any, are pseudo-random.
+ */
+class SobolSequence
+{
+public:
+    //! Number of dimensions with Sobol components
+    static constexpr index_type max_dimension = 16;
+
+    /*!
+     * Constructor
+     *
+     * @param dimension The dimension of the points
+     * @param seed The seed of the pseudo-random components beyond max_dimension
+     */
+    SobolSequence(index_type dimension, unsigned seed = 0)
+        : dimension(dimension), state(std::min(dimension, max_dimension), 0), directions(std::min(dimension, max_dimension)), engine(seed)
+    {
+        // Degree s, coefficients a and initial numbers m of the primitive polynomials
+        struct Polynomial
+        {
+            unsigned s, a;
+            std::array<std::uint32_t, 6> m;
+        };
+        static constexpr Polynomial polynomials[max_dimension - 1] = {
+            {1, 0, {1}},
+            {2, 1, {1, 3}},
+            {3, 1, {1, 3, 1}},
+            {3, 2, {1, 1, 1}},
+            {4, 1, {1, 1, 3, 3}},
+            {4, 4, {1, 3, 5, 13}},
+            {5, 2, {1, 1, 5, 5, 17}},
+            {5, 4, {1, 1, 5, 5, 5}},
+            {5, 7, {1, 1, 7, 11, 19}},
+            {5, 11, {1, 1, 5, 1, 1}},
+            {5, 13, {1, 1, 1, 3, 11}},
+            {5, 14, {1, 3, 5, 5, 31}},
+            {6, 1, {1, 3, 3, 9, 7, 49}},
+            {6, 13, {1, 1, 1, 15, 21, 21}},
+            {6, 16, {1, 3, 1, 13, 27, 49}},
+        };
+
+        for (std::size_t j = 0; j < directions.size(); ++j)
+        {
+            auto &v = directions[j];
+            if (j == 0)
+            {
+                // Van der Corput sequence in base 2
+                for (unsigned k = 0; k < bits; ++k)
+                    v[k] = std::uint32_t(1) << (31 - k);
+                continue;
+            }
+            const Polynomial &p = polynomials[j - 1];
+            for (unsigned k = 0; k < p.s; ++k)
+                v[k] = p.m[k] << (31 - k);
+            for (unsigned k = p.s; k < bits; ++k)
+            {
+                v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+                for (unsigned i = 1; i < p.s; ++i)
+                    if ((p.a >> (p.s - 1 - i)) & 1)
+                        v[k] ^= v[k - i];
+            }
+        }
+    }
+
+    /*!
+     * Next point of the sequence (the first one is the origin).
+     *
+     * @return A point of [0, 1)^dimension
+     */
+    vector_type next()
+    {
+        vector_type point(dimension);
+        for (std::size_t j = 0; j < state.size(); ++j)
+            point(j) = state[j] * 0x1p-32;
+        std::uniform_real_distribution<scalar_type> uniform(0.0, 1.0);
+        for (index_type j = state.size(); j < dimension; ++j)
+            point(j) = uniform(engine);
+
+        // Gray code update: flip the direction number of the lowest zero bit of the counter
+        unsigned c = 0;
+        while ((count >> c) & 1)
+            ++c;
+        for (std::size_t j = 0; j < state.size(); ++j)
+            state[j] ^= directions[j][c];
+        ++count;
+        return point;
+    }
+
+private:
+    static constexpr unsigned bits = 32;
+
+    index_type dimension;                                    // Dimension of the points
+    std::vector<std::uint32_t> state;                        // Current point, as 32 bit fractions
+    std::vector<std::array<std::uint32_t, bits>> directions; // Direction numbers of each dimension
+    std::uint64_t count = 0;                                 // Index of the next point
+    std::mt19937 engine;                                     // Components beyond max_dimension
+};
+
+#endif // SOBOL_HPP
@@ -0,0 +1,217 @@
+#ifndef STOCHASTIC_OBJECTIVE_HPP
+#define STOCHASTIC_OBJECTIVE_HPP
+
+#include <Math>
+#include <algorithm> // For std::shuffle
+#include <numeric>   // For std::iota
+#include <random>
+#include <span>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+/**
+ * \brief An objective of the form f(x) = (1/N) sum_i f_i(x)
+ *
+ * The gradients of the terms are computed by centered finite differences.
+ * Each term is a different callable object, so different terms can be
+ * evaluated at the same time by different threads. A copy has its own copies
+ * of the terms, so the copies held by concurrent runs (e.g. in the copies of
+ * the parameters of the multi-start or sweep drivers) share no state.
+ */
+class StochasticObjective
+{
+public:
+    StochasticObjective() = default;
+
+    //! Constructor with the terms f_i and the step for the finite differences
+    StochasticObjective(const std::vector<scalar_function> &terms, scalar_type h) : terms(terms), h(h) {}
+
+    //! Number of terms N
+    index_type size() const { return terms.size(); }
+
+    //! Step for the finite differences
+    scalar_type get_h() const { return h; }
+
+    /*!
+     * Evaluate the objective (mean of all the terms, computed in parallel).
+     *
+     * @param x The point
+     * @return f(x)
+     */
+    scalar_type operator()(const vector_type &x) const
+    {
+        const scalar_type sum = tbb::parallel_reduce(
+            tbb::blocked_range<index_type>(0, size()), scalar_type(0),
+            [&](const tbb::blocked_range<index_type> &range, scalar_type partial)
+            {
+                for (index_type i = range.begin(); i != range.end(); ++i)
+                    partial += terms[i](x);
+                return partial;
+            },
+            std::plus<scalar_type>());
+        return sum / size();
+    }
+
+    /*!
+     * Evaluate a single term.
+     *
+     * @param x The point
+     * @param i The index of the term
+     * @return f_i(x)
+     */
+    scalar_type term(const vector_type &x, index_type i) const { return terms[i](x); }
+
+    /*!
+     * Add the gradient of a term to an accumulator.
+     *
+     * @param z The point, it is modified during the computation and restored at the end
+     * @param i The index of the term
+     * @param grad The accumulator, grad += weight * grad f_i(z)
+     * @param weight The weight of the gradient
+     */
+    void add_grad_term(vector_type &z, index_type i, vector_type &grad, scalar_type weight = 1.0) const
+    {
+        const scalar_function &f_i = terms[i];
+        for (index_type j = 0; j < z.size(); ++j)
+        {
+            const scalar_type z_j = z(j);
+            z(j) = z_j + h;
+            const scalar_type f_forward = f_i(z);
+            z(j) = z_j - h;
+            const scalar_type f_backward = f_i(z);
+            z(j) = z_j;
+            grad(j) += weight * (f_forward - f_backward) / (2 * h);
+        }
+    }
+
+    /*!
+     * Gradient of a single term.
+     *
+     * @param x The point
+     * @param i The index of the term
+     * @return grad f_i(x)
+     */
+    vector_type grad_term(const vector_type &x, index_type i) const
+    {
+        vector_type z = x;
+        vector_type grad = vector_type::Zero(x.size());
+        add_grad_term(z, i, grad);
+        return grad;
+    }
+
+    /*!
+     * Mini-batch gradient, the terms of the batch are processed in parallel.
+     *
+     * @param x The point
+     * @param indices The indices of the terms in the batch
+     * @return (1/|B|) sum_{i in B} grad f_i(x)
+     */
+    vector_type grad_batch(const vector_type &x, std::span<const index_type> indices) const
+    {
+        const vector_type sum = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, indices.size()), vector_type(vector_type::Zero(x.size())),
+            [&](const tbb::blocked_range<std::size_t> &range, vector_type partial)
+            {
+                vector_type z = x;
+                for (std::size_t k = range.begin(); k != range.end(); ++k)
+                    add_grad_term(z, indices[k], partial);
+                return partial;
+            },
+            [](const vector_type &a, const vector_type &b) -> vector_type
+            { return a + b; });
+        return sum / std::max<std::size_t>(indices.size(), 1);
+    }
+
+    /*!
+     * Full gradient (all the terms, computed in parallel).
+     *
+     * @param x The point
+     * @return grad f(x)
+     */
+    vector_type grad(const vector_type &x) const
+    {
+        std::vector<index_type> all(size());
+        std::iota(all.begin(), all.end(), 0);
+        return grad_batch(x, all);
+    }
+
+private:
+    std::vector<scalar_function> terms; // Terms f_i
+    scalar_type h = 1e-2;               // Step for the finite differences
+};
+
+/**
+ * \brief Mini-batch estimate of the gradient of a StochasticObjective
+ *
+ * Every call returns the gradient of the next mini-batch of a random
+ * permutation of the terms. When an epoch is over the permutation is
+ * shuffled again in place, so no memory is allocated after construction
+ * (apart from the returned vector). It can be stored in a `vector_function`
+ * and used by any first-order method.
+ *
+ * A copy has its own objective and its own permutation, cursor and random
+ * engine (copied from the original, so every copy continues the same
+ * sequence of mini-batches independently). The copies of the parameters run
+ * concurrently by the drivers (multi-start, sweep, parallel tempering, the
+ * batch scheduler) therefore share no mutable state.
+ *
+ * @warning a single MiniBatchGradient must not be called by two threads at the same time
+ */
+class MiniBatchGradient
+{
+public:
+    /*!
+     * Constructor
+     *
+     * @param objective The objective f = (1/N) sum_i f_i
+     * @param batch_size The number of terms in each mini-batch
+     * @param seed The seed of the random permutations
+     */
+    MiniBatchGradient(const StochasticObjective &objective, index_type batch_size, unsigned seed = 0)
+        : objective(objective), batch_size(std::clamp<index_type>(batch_size, 1, objective.size())),
+          state(objective.size(), seed) {}
+
+    //! Gradient of the next mini-batch at x
+    vector_type operator()(const vector_type &x) const
+    {
+        State &s = state;
+        if (s.cursor >= objective.size())
+        {
+            // New epoch
+            std::shuffle(s.order.begin(), s.order.end(), s.engine);
+            s.cursor = 0;
+            ++s.epoch;
+        }
+        const index_type count = std::min(batch_size, objective.size() - s.cursor);
+        std::span<const index_type> batch(s.order.data() + s.cursor, count);
+        s.cursor += count;
+        return objective.grad_batch(x, batch);
+    }
+
+    //! Number of mini-batches in an epoch
+    index_type batches_per_epoch() const { return (objective.size() + batch_size - 1) / batch_size; }
+
+    //! Number of the current epoch (starting from 0)
+    index_type epoch() const { return state.epoch; }
+
+private:
+    // Permutation of the terms and position in the current epoch
+    struct State
+    {
+        State(index_type n, unsigned seed) : order(n), engine(seed)
+        {
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), engine);
+        }
+        std::vector<index_type> order;
+        std::mt19937 engine;
+        index_type cursor = 0;
+        index_type epoch = 0;
+    };
+
+    StochasticObjective objective; // Own copy of the objective
+    index_type batch_size;
+    mutable State state;           // Own permutation, advanced by every call
+};
+
+#endif // STOCHASTIC_OBJECTIVE_HPP
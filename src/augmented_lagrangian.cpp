@@ -0,0 +1,163 @@
+#include "augmented_lagrangian.hpp"
+#include "run.hpp"
+#include <tbb/parallel_invoke.h>
+
+/**
+ * @brief Augmented Lagrangian of a constrained problem, for fixed multipliers and penalty.
+ *
+ * \f[
+ *     L(x) = f(x) + \lambda^T h(x) + \frac{\rho}{2} \|h(x)\|^2
+ *          + \frac{1}{2 \rho} \left( \|\max(0, \mu + \rho g(x))\|^2 - \|\mu\|^2 \right)
+ * \f]
+ *
+ * The objective, the constraints and their derivatives are evaluated
+ * concurrently (each one is a different object, so no copies are needed).
+ */
+struct AugmentedLagrangian
+{
+    scalar_function f;
+    vector_function grad_f;
+    vector_function h;
+    matrix_function jac_h;
+    vector_function g;
+    matrix_function jac_g;
+    vector_type lambda; // Multipliers of the equality constraints
+    vector_type mu;     // Multipliers of the inequality constraints
+    scalar_type rho;    // Penalty parameter
+
+    // Values of the constraints at x (empty vectors if there are none)
+    std::pair<vector_type, vector_type> constraints(const vector_type &x) const
+    {
+        vector_type hx(0), gx(0);
+        tbb::parallel_invoke([&]
+                             { if (h) hx = h(x); },
+                             [&]
+                             { if (g) gx = g(x); });
+        return {hx, gx};
+    }
+
+    scalar_type value(const vector_type &x) const
+    {
+        scalar_type fx;
+        vector_type hx(0), gx(0);
+        tbb::parallel_invoke([&]
+                             { fx = f(x); },
+                             [&]
+                             { if (h) hx = h(x); },
+                             [&]
+                             { if (g) gx = g(x); });
+        return fx + lambda.dot(hx) + 0.5 * rho * hx.squaredNorm() +
+               0.5 / rho * ((mu + rho * gx).cwiseMax(0.0).squaredNorm() - mu.squaredNorm());
+    }
+
+    vector_type gradient(const vector_type &x) const
+    {
+        vector_type grad, hx, gx;
+        matrix_type Jh, Jg;
+        tbb::parallel_invoke([&]
+                             { grad = grad_f(x); },
+                             [&]
+                             { if (h) hx = h(x); },
+                             [&]
+                             { if (h) Jh = jac_h(x); },
+                             [&]
+                             { if (g) gx = g(x); },
+                             [&]
+                             { if (g) Jg = jac_g(x); });
+        if (h)
+            grad += Jh.transpose() * (lambda + rho * hx);
+        if (g)
+            grad += Jg.transpose() * (mu + rho * gx).cwiseMax(0.0);
+        return grad;
+    }
+};
+
+/**
+ * @brief Minimizes f subject to h(x) = 0 and g(x) <= 0 with an augmented Lagrangian outer loop around a method.
+ *
+ * Every outer iteration minimizes the augmented Lagrangian with the chosen
+ * (unconstrained) method, warm started from the previous minimizer, then
+ * updates the multipliers, \f$ \lambda \leftarrow \lambda + \rho h \f$ and
+ * \f$ \mu \leftarrow \max(0, \mu + \rho g) \f$, and multiplies the penalty
+ * by penalty_growth if the violation of the constraints has not decreased by
+ * at least a factor 4. The loop stops when the violation is less than
+ * constraint_tolerance. Since the multipliers absorb the constraints, the
+ * penalty stays moderate and the inner problems are much better conditioned
+ * than with a pure penalty in f.
+ *
+ * @param params The parameters of the unconstrained method.
+ * @param method_t The primary optimization method type.
+ * @param method_s The secondary strategy for some methods.
+ * @param options The constraints and the options of the driver.
+ */
+void run_augmented_lagrangian(const Params &params, const string_type &method_t, const string_type &method_s,
+                              const AugmentedLagrangianOptions &options)
+{
+    const std::unique_ptr<Method> prototype = make_solver(params, method_t, method_s);
+    if (!prototype)
+        return;
+
+    AugmentedLagrangian L{params.f, params.grad_f,
+                          options.eq_constraints, options.jac_eq_constraints,
+                          options.ineq_constraints, options.jac_ineq_constraints,
+                          vector_type(0), vector_type(0), options.penalty};
+    vector_type x = params.initial_condition;
+    auto [hx, gx] = L.constraints(x);
+    L.lambda = vector_type::Zero(hx.size());
+    L.mu = vector_type::Zero(gx.size());
+
+    prototype->print();
+    std::cout << "Equality constraints: " << hx.size() << ", inequality constraints: " << gx.size() << std::endl;
+    std::cout << "penalty: " << options.penalty << std::endl;
+    std::cout << "penalty_growth: " << options.penalty_growth << std::endl;
+    std::cout << "outer_iterations: " << options.outer_iterations << std::endl;
+    std::cout << "constraint_tolerance: " << options.constraint_tolerance << std::endl;
+
+    scalar_type previous_violation = std::numeric_limits<scalar_type>::infinity();
+    index_type iteration = 0;
+    for (iteration = 0; iteration < options.outer_iterations; ++iteration)
+    {
+        // Minimize the augmented Lagrangian, warm started from the previous minimizer
+        const auto solver = make_solver(params, method_t, method_s, [&](Params &p)
+                                        {
+                                            p.f = [L](const vector_type &y) { return L.value(y); };
+                                            p.grad_f = [L](const vector_type &y) { return L.gradient(y); };
+                                            p.initial_condition = x; });
+        {
+            SilentCout silent;
+            x = (*solver)();
+        }
+
+        // Violation of the constraints (an inactive inequality is satisfied if g <= -mu / rho)
+        std::tie(hx, gx) = L.constraints(x);
+        const scalar_type violation = std::max(hx.size() > 0 ? hx.cwiseAbs().maxCoeff() : 0.0,
+                                               gx.size() > 0 ? gx.cwiseMax(-L.mu / L.rho).cwiseAbs().maxCoeff() : 0.0);
+        std::cout << "Outer iteration " << iteration + 1 << ": f = " << params.f(x) << ", violation = " << violation
+                  << ", penalty = " << L.rho << std::endl;
+
+        // Update the multipliers
+        L.lambda += L.rho * hx;
+        L.mu = (L.mu + L.rho * gx).cwiseMax(0.0);
+
+        // Check for convergence (violation of the constraints)
+        if (violation < options.constraint_tolerance)
+        {
+            std::cout << "Converged in " << iteration + 1 << " outer iterations thanks to constraint criterion." << std::endl;
+            break;
+        }
+
+        // Update the penalty
+        if (violation > 0.25 * previous_violation)
+            L.rho *= options.penalty_growth;
+        previous_violation = violation;
+    }
+    if (iteration == options.outer_iterations)
+        std::cout << "Not converged (max_outer_iterations = " << iteration << ")" << std::endl;
+
+    Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+    if (hx.size() > 0)
+        std::cout << "Equality multipliers: " << L.lambda.format(commaFormat) << std::endl;
+    if (gx.size() > 0)
+        std::cout << "Inequality multipliers: " << L.mu.format(commaFormat) << std::endl;
+    print_result(x, params.f, params.grad_f);
+}
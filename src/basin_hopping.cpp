@@ -0,0 +1,173 @@
+#include "basin_hopping.hpp"
+#include "run.hpp"
+#include <random>
+#include <tbb/parallel_for.h>
+
+// A Markov chain of local minima
+struct Chain
+{
+    vector_type x;           // Current local minimum
+    scalar_type value;       // Value of f at x
+    vector_type best_x;      // Best local minimum visited
+    scalar_type best_value;  // Value of f at best_x
+    scalar_type temperature; // Temperature of the Metropolis test
+    std::mt19937 engine;     // Random engine of the chain
+    index_type accepted = 0; // Number of accepted hops
+};
+
+/**
+ * @brief Runs the local method from a point.
+ *
+ * @param params The parameters of the local method.
+ * @param method_t The primary type of the local method.
+ * @param method_s The secondary strategy of the local method.
+ * @param x0 The initial condition.
+ * @return The local minimum found.
+ */
+vector_type local_minimum(const Params &params, const string_type &method_t, const string_type &method_s,
+                          const vector_type &x0)
+{
+    const auto solver = make_solver(params, method_t, method_s, [&](Params &p)
+                                    { p.initial_condition = x0; });
+    return (*solver)();
+}
+
+/**
+ * @brief Advances a chain by some hops.
+ *
+ * Every hop perturbs the current local minimum with a uniform random step,
+ * runs the local method from the perturbed point and accepts the new local
+ * minimum with the Metropolis test at the temperature of the chain.
+ *
+ * @param chain The chain.
+ * @param hops The number of hops.
+ * @param params The parameters of the local method.
+ * @param method_t The primary type of the local method.
+ * @param method_s The secondary strategy of the local method.
+ * @param step_size The half width of the perturbations.
+ */
+void hop(Chain &chain, index_type hops, const Params &params, const string_type &method_t,
+         const string_type &method_s, scalar_type step_size)
+{
+    const scalar_function f = params.f; // Copy of f owned by this chain
+    std::uniform_real_distribution<scalar_type> uniform(-1.0, 1.0);
+    std::uniform_real_distribution<scalar_type> unit(0.0, 1.0);
+    vector_type trial(chain.x.size());
+    for (index_type h = 0; h < hops; ++h)
+    {
+        for (index_type i = 0; i < trial.size(); ++i)
+            trial(i) = chain.x(i) + step_size * uniform(chain.engine);
+        const vector_type x = local_minimum(params, method_t, method_s, trial);
+        const scalar_type value = f(x);
+        if (value < chain.value || unit(chain.engine) < std::exp(-(value - chain.value) / chain.temperature))
+        {
+            chain.x = x;
+            chain.value = value;
+            ++chain.accepted;
+            if (value < chain.best_value)
+            {
+                chain.best_x = x;
+                chain.best_value = value;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs basin hopping (or parallel tempering) with a local method and prints the best minimum found.
+ *
+ * If hopping_t is "Basin hopping" a single chain hops between local minima.
+ * If hopping_t is "Parallel tempering" several chains, with temperatures in
+ * geometric progression from temperature to max_temperature, hop
+ * concurrently (one TBB task each, so the local solves of different chains
+ * run on different cores) for swap_interval hops; the states of chains with
+ * neighbouring temperatures are then swapped with the Metropolis test
+ * \f$ \min(1, e^{(1/T_k - 1/T_{k+1})(f_k - f_{k+1})}) \f$, so that the
+ * minima found by the hot chains, which explore widely, reach the cold ones.
+ *
+ * @param params The parameters of the local method.
+ * @param method_t The primary type of the local method.
+ * @param method_s The secondary strategy of the local method.
+ * @param hopping_t The variant ("Basin hopping" or "Parallel tempering").
+ * @param options The options of the basin hopping driver.
+ */
+void run_basin_hopping(const Params &params, const string_type &method_t, const string_type &method_s,
+                       const string_type &hopping_t, const BasinHoppingOptions &options)
+{
+    index_type chains = 1;
+    if (hopping_t == "Parallel tempering")
+        chains = std::max<int_type>(options.chains, 2);
+    else if (hopping_t != "Basin hopping")
+    {
+        std::cerr << "Invalid basin hopping type" << std::endl;
+        return;
+    }
+    const std::unique_ptr<Method> prototype = make_solver(params, method_t, method_s);
+    if (!prototype)
+        return;
+
+    prototype->print();
+    std::cout << "Global strategy: " << hopping_t << std::endl;
+    std::cout << "hops: " << options.hops << std::endl;
+    std::cout << "step_size: " << options.step_size << std::endl;
+    std::cout << "temperature: " << options.temperature << std::endl;
+    if (chains > 1)
+    {
+        std::cout << "chains: " << chains << std::endl;
+        std::cout << "max_temperature: " << options.max_temperature << std::endl;
+        std::cout << "swap_interval: " << options.swap_interval << std::endl;
+    }
+
+    std::vector<Chain> ladder(chains);
+    const index_type interval = chains > 1 ? std::max<int_type>(options.swap_interval, 1) : std::max<int_type>(options.hops, 1);
+    index_type swaps = 0, accepted_swaps = 0;
+    {
+        SilentCout silent;
+
+        // All the chains start from the local minimum of the initial condition
+        const vector_type x = local_minimum(params, method_t, method_s, params.initial_condition);
+        const scalar_type value = params.f(x);
+        for (index_type k = 0; k < chains; ++k)
+        {
+            const scalar_type ratio = chains > 1 ? static_cast<scalar_type>(k) / (chains - 1) : 0.0;
+            const scalar_type temperature = options.temperature * std::pow(options.max_temperature / options.temperature, ratio);
+            ladder[k] = {x, value, x, value, temperature, std::mt19937(k)};
+        }
+
+        std::mt19937 engine(chains); // Random engine of the swaps
+        std::uniform_real_distribution<scalar_type> unit(0.0, 1.0);
+        for (index_type done = 0; done < options.hops; done += interval)
+        {
+            // Advance the chains concurrently
+            const index_type hops = std::min<index_type>(interval, options.hops - done);
+            tbb::parallel_for(index_type(0), chains, [&](index_type k)
+                              { hop(ladder[k], hops, params, method_t, method_s, options.step_size); }, tbb::simple_partitioner());
+
+            // Swap the states of neighbouring chains (even and odd pairs in alternate rounds)
+            for (index_type k = (done / interval) % 2; k + 1 < chains; k += 2)
+            {
+                ++swaps;
+                const scalar_type delta = (1.0 / ladder[k].temperature - 1.0 / ladder[k + 1].temperature) * (ladder[k].value - ladder[k + 1].value);
+                if (delta >= 0.0 || unit(engine) < std::exp(delta))
+                {
+                    std::swap(ladder[k].x, ladder[k + 1].x);
+                    std::swap(ladder[k].value, ladder[k + 1].value);
+                    ++accepted_swaps;
+                }
+            }
+        }
+    }
+
+    // Best minimum of all the chains
+    index_type best = 0;
+    for (index_type k = 0; k < chains; ++k)
+    {
+        std::cout << "Chain " << k + 1 << " (temperature " << ladder[k].temperature << "): " << ladder[k].accepted
+                  << " accepted hops out of " << options.hops << ", best f = " << ladder[k].best_value << std::endl;
+        if (ladder[k].best_value < ladder[best].best_value)
+            best = k;
+    }
+    if (chains > 1)
+        std::cout << "Accepted swaps: " << accepted_swaps << " out of " << swaps << std::endl;
+    print_result(ladder[best].best_x, params.f, params.grad_f);
+}
@@ -8,60 +8,67 @@ int main()
 {
     const GetPot datafile("data.txt"); 
 
-    const bool gradient_descent = datafile("gradient_descent", "true");
-    if (gradient_descent)
-    {
-        // Read gradient descent parameters
-        std::cout << "GRADIENT DESCENT" << std::endl;        
-        GradientDescentParams params_gd;
-        read(datafile, params_gd);
+    // List of the registered methods: if true the methods and their variants are printed before running
+    if (string_type(datafile("list_methods", "false")) == "true")
+        print_methods();
 
-        // Run the gradient descent algorithm with the chosen strategy
-        const string_type gradient_method_t = datafile("gradient_method_t", "Armijo rule"); // Rule to compute the step size for the gradient descent algorithm
-        run(params_gd, gradient_method_t, "");
-    }
+    // Multi-start: if true every method is run from several starting points in the box
+    const bool multistart = string_type(datafile("multistart", "false")) == "true";
+    MultiStartOptions options_ms;
+    if (multistart)
+        read(datafile, options_ms);
 
-    const bool heavy_ball = datafile("heavy_ball", "true");
-    if (heavy_ball)
-    {
-        // Read heavy ball parameters
-        std::cout << "HEAVY BALL" << std::endl;
-        HeavyBallParams params_hb;
-        read(datafile, params_hb);
-        
-        // Run the heavy ball algorithm with the chosen strategy
-        const string_type heavy_ball_t = datafile("heavy_ball_t", "Exponential decay"); // Rule for the step size
-        const string_type heavy_ball_s = datafile("heavy_ball_s", "Constant");          // Rule for eta
-        run(params_hb, heavy_ball_t, heavy_ball_s);
-    }
+    // Basin hopping: if true every method is used as the local minimizer of a basin hopping search
+    const bool basin_hopping = string_type(datafile("basin_hopping", "false")) == "true";
+    const string_type basin_hopping_t = datafile("basin_hopping_t", "Basin hopping"); // Single chain or parallel tempering
+    BasinHoppingOptions options_bh;
+    if (basin_hopping)
+        read(datafile, options_bh);
 
-    const bool nesterov = datafile("nesterov", "true");
-    if (nesterov)
-    {
-        // Read Nesterov parameters
-        std::cout << "NESTEROV" << std::endl;
+    // Augmented Lagrangian: if true every method minimizes f subject to the constraints
+    const bool augmented_lagrangian = string_type(datafile("augmented_lagrangian", "false")) == "true";
+    AugmentedLagrangianOptions options_al;
+    if (augmented_lagrangian)
+        read(datafile, options_al);
 
-        NesterovParams params_n;
-        read(datafile, params_n);
-        
-        // Run the nesterov algorithm with the chosen strategy
-        const string_type nesterov_t = datafile("nesterov_t", "Exponential decay"); // Rule for the step size
-        const string_type nesterov_s = datafile("nesterov_s", "Constant");          // Rule for eta
-        run(params_n, nesterov_t, nesterov_s);
-    }
+    // Parameter sweep: if true every method minimizes f for a range of values of a parameter
+    const bool sweep = string_type(datafile("sweep", "false")) == "true";
+    SweepOptions options_sw;
+    if (sweep)
+        read(datafile, options_sw);
+
+    const auto solve = [&](const Params &params, const string_type &method_t, const string_type &method_s)
+    {
+        if (sweep)
+            run_sweep(params, method_t, method_s, options_sw);
+        else if (augmented_lagrangian)
+            run_augmented_lagrangian(params, method_t, method_s, options_al);
+        else if (basin_hopping)
+            run_basin_hopping(params, method_t, method_s, basin_hopping_t, options_bh);
+        else if (multistart)
+            run_multistart(params, method_t, method_s, options_ms);
+        else
+            run(params, method_t, method_s);
+    };
 
-    const bool adam = datafile("adam", "true");
-    if (adam)
+    // Run every method selected in the data file, in the order of their descriptions, with the variant given by its method strings
+    const SolverRegistry &registry = SolverRegistry::instance();
+    for (const string_type &method : registry.methods())
     {
-        // Read Adam parameters
-        std::cout << "ADAM" << std::endl;
+        const SolverRegistry::MethodInfo *info = registry.described(method);
+        const SolverRegistry::Description &description = info->description;
+        if (string_type(datafile(method.c_str(), description.selected ? "true" : "false")) != "true")
+            continue;
+
+        // Read the parameters of the method
+        std::cout << description.title << std::endl;
+        const std::unique_ptr<Params> params = info->make_params();
+        info->read(datafile, *params);
 
-        AdamParams params_a;
-        read(datafile, params_a);
-        
-        // Run the adam algorithm with the chosen strategy
-        const string_type adam_t = datafile("adam_t", "Exponential decay"); // Rule for the step size
-        run(params_a, adam_t, "");
+        // Run the method with the chosen variant
+        const string_type method_t = description.key_t.empty() ? "" : datafile(description.key_t.c_str(), description.default_t.c_str());
+        const string_type method_s = description.key_s.empty() ? "" : datafile(description.key_s.c_str(), description.default_s.c_str());
+        solve(*params, method_t, method_s);
     }
 
     return 0;
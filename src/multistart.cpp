@@ -0,0 +1,222 @@
+#include "multistart.hpp"
+#include "batch_scheduler.hpp"
+#include "run.hpp"
+#include "sobol.hpp"
+#include <algorithm> // For std::sort
+#include <atomic>
+#include <memory>    // For std::shared_ptr
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+/**
+ * @brief Lowers an atomic value if the new value is smaller.
+ *
+ * @param target The atomic value.
+ * @param value The new value.
+ */
+void fetch_min(std::atomic<scalar_type> &target, scalar_type value)
+{
+    scalar_type current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+/**
+ * @brief Monitor of the evaluations of f of a single start.
+ *
+ * Every prune_interval evaluations the best value of the start is
+ * compared with the best value found by all the starts. The start is
+ * abandoned if it is clearly worse (by more than 1e-3 (1 + |best|)) and,
+ * improving at the rate of the last interval, it could not close the gap
+ * in as many intervals as it has already used.
+ */
+class StartMonitor
+{
+public:
+    StartMonitor(std::atomic<scalar_type> &shared_best, int_type prune_interval)
+        : shared_best(shared_best), prune_interval(prune_interval) {}
+
+    // Records a value of f and checks whether the start has to be abandoned
+    void observe(scalar_type value)
+    {
+        fetch_min(best, value);
+        fetch_min(shared_best, value);
+        const index_type count = ++evaluations;
+        if (prune_interval <= 0 || count % prune_interval != 0)
+            return;
+
+        const scalar_type current = best.load(std::memory_order_relaxed);
+        const scalar_type previous = best_at_check.exchange(current, std::memory_order_relaxed);
+        const scalar_type global = shared_best.load(std::memory_order_relaxed);
+        const scalar_type gap = current - global;
+        const index_type checks = count / prune_interval;
+        if (gap > 1e-3 * (1.0 + std::abs(global)) && (previous - current) * checks < gap)
+            pruned.store(true, std::memory_order_relaxed);
+    }
+
+    bool is_pruned() const { return pruned.load(std::memory_order_relaxed); }
+    scalar_type value() const { return best.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<scalar_type> &shared_best; // Best value of all the starts
+    const int_type prune_interval;
+    std::atomic<scalar_type> best{std::numeric_limits<scalar_type>::infinity()};
+    std::atomic<scalar_type> best_at_check{std::numeric_limits<scalar_type>::infinity()};
+    std::atomic<index_type> evaluations{0};
+    std::atomic<bool> pruned{false};
+};
+
+// Outcome of a start
+struct Start
+{
+    vector_type x;
+    scalar_type value;
+    bool pruned;
+};
+
+// A distinct minimum and the number of starts that reached it
+struct Minimum
+{
+    vector_type x;
+    scalar_type value;
+    int_type count;
+};
+
+/**
+ * @brief Runs a local method from several starting points in parallel and prints the distinct minima found.
+ *
+ * The starting points are the first points of a Sobol sequence (skipping the
+ * origin) scaled to the box, so they cover it evenly for any number of starts.
+ * The starts run concurrently, each one with its own solver and its own copy
+ * of f and grad_f. These are wrapped so that every start publishes its values
+ * in a lock-free best-so-far value shared by all the starts; once a start is
+ * pruned (see StartMonitor) f returns its best value and grad_f zero, so that
+ * the solver stops at its next convergence check. The results of the
+ * remaining starts are clustered with radius cluster_radius.
+ *
+ * With scheduler_threads > 0 the starts are coroutines (see Method::solve)
+ * interleaved by a BatchScheduler on that many threads: the evaluations
+ * requested by all the starts in a round are evaluated together, so many
+ * small starts do not need a task each.
+ *
+ * @param params The parameters for the optimization method.
+ * @param method_t The primary optimization method type.
+ * @param method_s The secondary strategy for some methods.
+ * @param options The options of the multi-start driver.
+ */
+void run_multistart(const Params &params, const string_type &method_t, const string_type &method_s,
+                    const MultiStartOptions &options)
+{
+    const std::unique_ptr<Method> prototype = make_solver(params, method_t, method_s);
+    if (!prototype)
+        return;
+
+    const index_type n = params.initial_condition.size();
+    const index_type K = std::max<int_type>(options.starts, 1);
+    const vector_type width = options.upper_bounds - options.lower_bounds;
+
+    // Starting points
+    SobolSequence sobol(n);
+    sobol.next();
+    matrix_type starts(n, K);
+    for (index_type k = 0; k < K; ++k)
+        starts.col(k) = options.lower_bounds + sobol.next().cwiseProduct(width);
+
+    prototype->print();
+    Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+    std::cout << "Multi-start in the box " << options.lower_bounds.format(commaFormat) << " - "
+              << options.upper_bounds.format(commaFormat) << std::endl;
+    std::cout << "starts: " << K << std::endl;
+    std::cout << "prune_interval: " << options.prune_interval << std::endl;
+    std::cout << "cluster_radius: " << options.cluster_radius << std::endl;
+    if (options.scheduler_threads > 0)
+        std::cout << "scheduler_threads: " << options.scheduler_threads << std::endl;
+
+    // Solver of the k-th start, with f and grad_f wrapped by the monitor of the start
+    std::atomic<scalar_type> shared_best(std::numeric_limits<scalar_type>::infinity());
+    std::vector<std::shared_ptr<StartMonitor>> monitors(K);
+    auto make_start = [&](index_type k)
+    {
+        auto monitor = monitors[k] = std::make_shared<StartMonitor>(shared_best, options.prune_interval);
+        return make_solver(params, method_t, method_s, [&](Params &p)
+                           {
+                               p.initial_condition = starts.col(k);
+                               p.f = [f = p.f, monitor](const vector_type &x)
+                               {
+                                   if (monitor->is_pruned())
+                                       return monitor->value();
+                                   const scalar_type value = f(x);
+                                   monitor->observe(value);
+                                   return value;
+                               };
+                               if (p.grad_f)
+                                   p.grad_f = [grad_f = p.grad_f, monitor](const vector_type &x) -> vector_type
+                                   {
+                                       if (monitor->is_pruned())
+                                           return vector_type::Zero(x.size());
+                                       return grad_f(x);
+                                   }; });
+    };
+
+    // Run the starts
+    tbb::enumerable_thread_specific<scalar_function> local_f(params.f);
+    std::vector<Start> results(K);
+    if (options.scheduler_threads > 0)
+    {
+        // Interleave the starts as coroutines on a fixed number of threads
+        std::vector<std::unique_ptr<Method>> solvers;
+        std::vector<Solve> solves;
+        for (index_type k = 0; k < K; ++k)
+        {
+            solvers.push_back(make_start(k));
+            solves.push_back(solvers.back()->solve());
+        }
+        BatchScheduler scheduler(options.scheduler_threads);
+        std::vector<std::unique_ptr<State>> states;
+        {
+            SilentCout silent;
+            states = scheduler.run(solves);
+        }
+        tbb::parallel_for(index_type(0), K, [&](index_type k)
+                          { results[k] = {states[k]->x, local_f.local()(states[k]->x), monitors[k]->is_pruned()}; });
+        std::cout << "Batches of evaluations: " << scheduler.get_batches() << " (" << scheduler.get_evaluations()
+                  << " evaluations)" << std::endl;
+    }
+    else
+    {
+        SilentCout silent;
+        tbb::parallel_for(index_type(0), K, [&](index_type k)
+                          {
+                              const auto solver = make_start(k);
+                              const vector_type x = (*solver)();
+                              results[k] = {x, local_f.local()(x), monitors[k]->is_pruned()}; }, tbb::simple_partitioner());
+    }
+
+    // Cluster the minima, from the best one
+    std::vector<index_type> order;
+    for (index_type k = 0; k < K; ++k)
+        if (!results[k].pruned)
+            order.push_back(k);
+    std::sort(order.begin(), order.end(), [&](index_type a, index_type b)
+              { return results[a].value < results[b].value; });
+    std::vector<Minimum> minima;
+    for (index_type k : order)
+    {
+        auto same = std::find_if(minima.begin(), minima.end(), [&](const Minimum &m)
+                                 { return (m.x - results[k].x).norm() <= options.cluster_radius; });
+        if (same != minima.end())
+            ++same->count;
+        else
+            minima.push_back({results[k].x, results[k].value, 1});
+    }
+
+    std::cout << "Completed starts: " << order.size() << ", pruned starts: " << K - order.size() << std::endl;
+    for (std::size_t i = 0; i < minima.size(); ++i)
+        std::cout << "Minimum " << i + 1 << ": " << minima[i].x.format(commaFormat) << ", f = " << minima[i].value
+                  << " (found by " << minima[i].count << " starts)" << std::endl;
+    if (minima.empty())
+        std::cout << "All the starts have been pruned" << std::endl
+                  << std::endl;
+    else
+        print_result(minima[0].x, params.f, params.grad_f);
+}
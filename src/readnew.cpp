@@ -1,19 +1,242 @@
 #include "readnew.hpp"
 
-/// @brief 
-/// @param datafile 
-/// @param params 
-void read(const GetPot &datafile, Params &params)
+/// @brief Reads the named parameters of the expressions
+/// @param datafile GetPot object with the names (list "parameters") and the values (one variable for each name)
+/// @return the parameters, a vector parameter for each name with more than one value
+Parameters read_parameters(const GetPot &datafile)
+{
+    Parameters parameters;
+    const int_type count = datafile.vector_variable_size("parameters");
+    for (int_type k = 0; k < count; ++k)
+    {
+        const string_type name = datafile("parameters", "", k);
+        if (name.empty())
+            continue;
+        const int_type size = datafile.vector_variable_size(name.c_str());
+        if (size > 1)
+        {
+            vector_type value(size);
+            for (int_type i = 0; i < size; ++i)
+                value(i) = datafile(name.c_str(), 0.0, i);
+            parameters.set(name, value);
+        }
+        else
+        {
+            parameters.set(name, datafile(name.c_str(), 0.0));
+        }
+    }
+    return parameters;
+}
+
+/// @brief Reads the terms f_i of an objective f = (1/N) sum_i f_i
+/// @param datafile GetPot object with the terms
+/// @param N dimension of the problem
+/// @param parameters named parameters of the expressions
+/// @return the objective, the gradients of the terms use finite differences with step h
+StochasticObjective read_stochastic_objective(const GetPot &datafile, int_type N, const Parameters &parameters)
+{
+    const string_type terms_str = datafile("terms", "{(x[0] - 1)^2, (x[1] + 1)^2, (x[0] - x[1])^2}"); // Terms f_i
+    const scalar_type h = datafile("h", 1e-2);                                                        // Step for the gradients of the terms
+    std::vector<scalar_function> terms;
+    for (const string_type &term : list_elements(terms_str))
+        terms.push_back(muParserXScalarInterface(term, N, parameters));
+    std::cout << "Mean of " << terms.size() << " terms: " << terms_str << std::endl;
+    return StochasticObjective(terms, h);
+}
+
+/// @brief Reads the box of the global optimization methods
+/// @param datafile GetPot object with the bounds
+/// @param N dimension of the problem
+/// @return the lower and the upper corners of the box
+std::pair<vector_type, vector_type> read_bounds(const GetPot &datafile, int_type N)
+{
+    vector_type lower_bounds(N), upper_bounds(N);
+    for (int i = 0; i < N; ++i)
+    {
+        lower_bounds[i] = datafile("lower_bounds", -1.0, i); // default -1.0 if not found
+        upper_bounds[i] = datafile("upper_bounds", 1.0, i);  // default 1.0 if not found
+    }
+    return {lower_bounds, upper_bounds};
+}
+
+/// @brief Reads the box of the projected first-order methods
+/// @param datafile GetPot object with the bounds
+/// @param N dimension of the problem
+/// @return the box (without bounds if the projected variants are not selected)
+Box read_box(const GetPot &datafile, int_type N)
+{
+    if (string_type(datafile("projected", "false")) != "true")
+        return {};
+    const auto [lower_bounds, upper_bounds] = read_bounds(datafile, N);
+    return {lower_bounds, upper_bounds};
+}
+
+/// @brief Reads the diagonal preconditioner of gradient descent and heavy ball
+/// @param datafile GetPot object with the options
+/// @return the preconditioner (none if it is not selected)
+Preconditioner read_preconditioner(const GetPot &datafile)
+{
+    Preconditioner preconditioner;
+    const string_type preconditioner_t = datafile("preconditioner", "None");
+    if (preconditioner_t == "Finite differences")
+        preconditioner.type = PreconditionerType::finite_differences;
+    else if (preconditioner_t == "Hutchinson")
+        preconditioner.type = PreconditionerType::hutchinson;
+    preconditioner.interval = datafile("precondition_interval", 0); // Iterations between two estimates
+    preconditioner.h = datafile("preconditioner_h", 1e-3);          // Step of the differences
+    preconditioner.probes = datafile("probes", 8);                  // Random probes (Hutchinson)
+    return preconditioner;
+}
+
+/// @brief Reads the parameters of the Polyak and hypergradient step sizes
+/// @param datafile GetPot object with the options
+/// @return the parameters of the adaptation of the step size
+StepAdaptation read_step_adaptation(const GetPot &datafile)
+{
+    StepAdaptation adaptation;
+    adaptation.lower_bound = datafile("f_lower_bound", 0.0); // Known lower bound of f (Polyak)
+    adaptation.hyper_rate = datafile("hyper_rate", 1e-3);    // Learning rate of the step size (hypergradient)
+    return adaptation;
+}
+
+/// @brief Expressions of f and of its gradient, read once from the data file
+struct ObjectiveDefinition
 {
-    const int_type N = datafile.vector_variable_size("initial_condition");                                 // Dimension of the problem
-    const string_type f_str = datafile("f", "4*x[0]*x[0]*x[0]*x[0] + 2*x[1]*x[1] + 2*x[0]*x[1] + 2*x[0]"); // Function f
+    string_type f;      // Function f
+    string_type grad_f; // Exact gradient of f (used if fd is false)
+    bool fd;            // Use finite differences to compute the gradient
+    string_type fd_t;   // Type of the finite differences
+    scalar_type h;      // Step of the finite differences
+
+    /// @brief Parses f and its gradient
+    /// @param N dimension of the problem
+    /// @param parameters named parameters of the expressions
+    /// @return f and its gradient (exact or with finite differences)
+    std::pair<scalar_function, vector_function> parse(int_type N, const Parameters &parameters) const
+    {
+        muParserXScalarInterface function(f, N, parameters); // Initialize the function with muparserx
+        vector_function gradient_f;
+        if (!fd)
+        {
+            gradient_f = muParserXVectorInterface(grad_f, N, parameters); // Initialize the gradient with muparserx
+        }
+        else if (fd_t == "Forward")
+        {
+            gradient_f = gradient<decltype(function), scalar_type, DifferenceType::Forward>(function, h);
+        }
+        else if (fd_t == "Backward")
+        {
+            gradient_f = gradient<decltype(function), scalar_type, DifferenceType::Backward>(function, h);
+        }
+        else
+        {
+            gradient_f = gradient<decltype(function), scalar_type, DifferenceType::Centered>(function, h);
+        }
+        return {function, gradient_f};
+    }
+};
+
+/// @brief Reads the expressions of f and of its gradient
+/// @param datafile GetPot object with the expressions
+/// @return the definition of the objective, parsed with ObjectiveDefinition::parse
+ObjectiveDefinition read_objective(const GetPot &datafile)
+{
+    ObjectiveDefinition definition;
+    definition.f = datafile("f", "4*x[0]*x[0]*x[0]*x[0] + 2*x[1]*x[1] + 2*x[0]*x[1] + 2*x[0]"); // Function f
+    definition.grad_f = datafile("grad_f", "{16*x[0]*x[0]*x[0] + 2*x[1] +2, 4*x[1]+2*x[0]}");  // Gradient of f
+    definition.fd = datafile("fd", true);                                                        // Use finite differences to compute the gradient
+    definition.fd_t = datafile("fd_t", "Centered");                                              // Finite differences type
+    definition.h = datafile("h", 1e-2);                                                          // Discretization step
+    return definition;
+}
+
+/// @brief Reads the Jacobian of a vector function
+/// @param datafile GetPot object with the finite differences options and the expression of the Jacobian
+/// @param function the vector function
+/// @param key name of the expression of the Jacobian in the datafile (used if fd = 0)
+/// @param default_jacobian expression of the Jacobian if the key is missing
+/// @param N dimension of the problem
+/// @param parameters named parameters of the expressions
+/// @return the Jacobian, with finite differences if fd = 1 and parsed with muparserx otherwise
+matrix_function read_jacobian(const GetPot &datafile, const muParserXVectorInterface &function, const string_type &key,
+                              const string_type &default_jacobian, int_type N, const Parameters &parameters)
+{
+    if (!datafile("fd", true))
+    {
+        const string_type jac_str = datafile(key.c_str(), default_jacobian.c_str()); // Jacobian of the function
+        return muParserXInterface(jac_str, N, parameters);                          // Initialize the jacobian with muparserx
+    }
+    const string_type fd_t = datafile("fd_t", "Centered");
+    const scalar_type h = datafile("h", 1e-2);
+    if (fd_t == "Forward")
+    {
+        return jacobian<muParserXVectorInterface, scalar_type, DifferenceType::Forward>(function, h);
+    }
+    else if (fd_t == "Backward")
+    {
+        return jacobian<muParserXVectorInterface, scalar_type, DifferenceType::Backward>(function, h);
+    }
+    return jacobian<muParserXVectorInterface, scalar_type, DifferenceType::Centered>(function, h);
+}
+
+/// @brief Reads a vector of constraints and its Jacobian
+/// @param datafile GetPot object with the constraints
+/// @param name name of the constraints in the datafile
+/// @param N dimension of the problem
+/// @param parameters named parameters of the expressions
+/// @return the constraints and their Jacobian (empty functions if there are no constraints)
+std::pair<vector_function, matrix_function> read_constraints(const GetPot &datafile, const string_type &name, int_type N,
+                                                             const Parameters &parameters)
+{
+    const string_type constraints_str = datafile(name.c_str(), "");
+    if (list_elements(constraints_str).empty())
+        return {};
+    std::cout << name << ": " << constraints_str << std::endl;
+    muParserXVectorInterface constraints(constraints_str, N, parameters); // Initialize the constraints with muparserx
+
+    const matrix_function jac = read_jacobian(datafile, constraints, "jac_" + name, "", N, parameters); // Jacobian of the constraints
+    return {constraints, jac};
+}
+
+/// @brief Data of the problem, shared by the parameters of all the methods
+struct Problem
+{
+    int_type N;                      // Dimension of the problem
+    string_type f_str;               // Expression of f
+    bool fd;                         // True if the gradient is approximated with finite differences
+    bool stochastic;                 // True if f is the mean of the terms of a stochastic objective
+    Parameters parameters;           // Named parameters of the expressions
+    scalar_function f;               // Objective function
+    vector_function grad_f;          // Gradient of the objective function
+    vector_type initial_condition;   // Initial condition
+    scalar_type tolerance_r;         // Tolerance for convergence (residual)
+    scalar_type tolerance_s;         // Tolerance for convergence (step length)
+    scalar_type initial_step;        // Initial step size
+    int_type max_iterations;         // Maximal number of iterations
+    scalar_type mu;                  // Parameter for the exponential and inverse decay
+    scalar_type minimum_step;        // Minimum step size
+};
+
+/// @brief Reads the data of the problem
+/// @param datafile GetPot object with the objective, the initial condition and the tolerances
+/// @return the data of the problem
+Problem read_problem(const GetPot &datafile)
+{
+    const int_type N = datafile.vector_variable_size("initial_condition"); // Dimension of the problem
+    const ObjectiveDefinition objective = read_objective(datafile);        // Expressions of f and of its gradient
+    const string_type &f_str = objective.f;
+    const bool fd = objective.fd;
     std::cout << "Function to be optimized: " << f_str << std::endl;
-    muParserXScalarInterface f(f_str, N);                           // Initialize the function with muparserx
-    const bool fd = datafile("fd", true);                           // Use finite differences to compute the gradient
+    const Parameters parameters = read_parameters(datafile); // Named parameters of the expressions
+    scalar_function f;
+    vector_function grad_f;
+    std::tie(f, grad_f) = objective.parse(N, parameters);
+    if (fd)
+        std::cout << "Finite differences type: " << objective.fd_t << " (h = " << objective.h << ")" << std::endl;
     const scalar_type tolerance_r = datafile("tolerance_r", 1e-6);  // Tolerance for convergence (residual)
     const scalar_type tolerance_s = datafile("tolerance_s", 1e-6);  // Tolerance for convergence (step length)
     const scalar_type initial_step = datafile("initial_step", 1.0); // Initial step size αlpha0
-    const int max_iterations = datafile("max_iterations", 1000);    // Maximal number of iterations
+    int max_iterations = datafile("max_iterations", 1000);          // Maximal number of iterations
     const scalar_type mu = datafile("mu", 0.2);                     // Parameter for the exponential and inverse decay
     const scalar_type minimum_step = datafile("minimum_step", 1e-2); // Minimum step size
 
@@ -32,115 +255,595 @@ void read(const GetPot &datafile, Params &params)
         initial_condition = vector_type::Zero(2);
     }
 
-    // Gradient of f
-    std::function<vector_type(const vector_type &)> grad_f;
-    
-    // if user prefers to use the approximate gradient
-    if (fd)
-    {
-        const string_type fd_t = datafile("fd_t", "Centered");
-        const scalar_type h = datafile("h", 1e-2);
-        std::cout << "Finite differences type: " << fd_t << " (h = " << h << ")" << std::endl;
-        if (fd_t == "Forward")
-        {
-            grad_f = gradient<decltype(f), scalar_type, DifferenceType::Forward>(f, h);
-        }
-        else if (fd_t == "Backward")
-        {
-            grad_f = gradient<decltype(f), scalar_type, DifferenceType::Backward>(f, h);
-        }
-        else
-        {
-            grad_f = gradient<decltype(f), scalar_type, DifferenceType::Centered>(f, h);
-        }
-    }
-    else
+    // Stochastic mode: f is the mean of the terms and the gradient is estimated on mini-batches
+    const bool stochastic = string_type(datafile("stochastic", "false")) == "true";
+    if (stochastic)
     {
-        const string_type grad_f_str = datafile("grad_f", "{16*x[0]*x[0]*x[0] + 2*x[1] +2, 4*x[1]+2*x[0]}"); // Gradient of f
-        muParserXVectorInterface grad_f(grad_f_str, N);                                                      // Initialize the gradient with muparserx
+        const int_type batch_size = datafile("batch_size", 1); // Terms in each mini-batch
+        const int_type epochs = datafile("epochs", 100);       // Number of epochs
+        std::cout << "Stochastic mode" << std::endl;
+        const StochasticObjective objective = read_stochastic_objective(datafile, N, parameters);
+        MiniBatchGradient mini_batch(objective, batch_size);
+        std::cout << "Mini-batches of " << batch_size << " terms, " << epochs << " epochs" << std::endl;
+        f = [objective](const vector_type &x)
+        { return objective(x); };
+        grad_f = mini_batch;
+        max_iterations = epochs * mini_batch.batches_per_epoch();
     }
 
-    
-    if (dynamic_cast<GradientDescentParams *>(&params) != nullptr)
-    {
-        auto *p = dynamic_cast<GradientDescentParams *>(&params);
-        // Gradient descent specific paramters
-        const scalar_type sigma = datafile("sigma", 0.1);       // Parameter for the Armijo rule  
-        *p = {
-            f,
-            grad_f,
-            initial_condition,
-            tolerance_r,
-            tolerance_s,
-            initial_step,
-            max_iterations,
-            minimum_step,
-            sigma,
-            mu,
-        };
-        return;
-    }
+    return {N, f_str, fd, stochastic, parameters, f, grad_f, initial_condition,
+            tolerance_r, tolerance_s, initial_step, max_iterations, mu, minimum_step};
+}
 
-    else if (dynamic_cast<HeavyBallParams *>(&params) != nullptr)
+/// @brief Reads the parameters of gradient descent
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of gradient descent
+void read(const GetPot &datafile, const Problem &problem, GradientDescentParams &params)
+{
+    // Gradient descent specific paramters
+    const scalar_type sigma = datafile("sigma", 0.1);       // Parameter for the Armijo rule  
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        sigma,
+        problem.mu,
+        read_box(datafile, problem.initial_condition.size()),
+        read_preconditioner(datafile),
+        read_step_adaptation(datafile),
+    };
+}
+
+/// @brief Reads the parameters of the heavy ball method
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the heavy ball method
+void read(const GetPot &datafile, const Problem &problem, HeavyBallParams &params)
+{
+    // Heavy ball specific paramters
+    const scalar_type eta = datafile("eta", 0.9);       // Memory parameter for Heavy ball
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        problem.mu,
+        eta,
+        read_box(datafile, problem.initial_condition.size()),
+        read_preconditioner(datafile),
+        read_step_adaptation(datafile),
+    };
+}
+
+/// @brief Reads the parameters of Nesterov's method
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of Nesterov's method
+void read(const GetPot &datafile, const Problem &problem, NesterovParams &params)
+{
+    // Nesterov specific paramters
+    const scalar_type eta = datafile("eta_nest", 0.9);   // Memory parameter for Nesterov
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        problem.mu,
+        eta,
+        read_box(datafile, problem.initial_condition.size()),
+        read_step_adaptation(datafile),
+    };
+}
+
+/// @brief Reads the parameters of Adam
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of Adam
+void read(const GetPot &datafile, const Problem &problem, AdamParams &params)
+{
+    // Adam specific paramters
+    const scalar_type beta1 = datafile("beta1", 0.9);     // Exponential decay rate for 1st moment estimate
+    const scalar_type beta2 = datafile("beta2", 0.999);   // Exponential decay rate for 2nd moment estimate
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        problem.mu,
+        beta1,
+        beta2,
+        read_box(datafile, problem.initial_condition.size()),
+    };
+}
+
+/// @brief Reads the parameters of Levenberg-Marquardt
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of Levenberg-Marquardt
+void read(const GetPot &datafile, const Problem &problem, LevenbergMarquardtParams &params)
+{
+    // Levenberg-Marquardt specific paramters
+    const string_type residuals_str = datafile("residuals", "{1 - x[0], 10*(x[1] - x[0]*x[0])}"); // Residuals r
+    std::cout << "Residuals: " << residuals_str << std::endl;
+    muParserXVectorInterface residuals(residuals_str, problem.N, problem.parameters); // Initialize the residuals with muparserx
+    const scalar_type lambda = datafile("lambda", 1e-3);   // Initial damping parameter
+
+    const matrix_function jac_r = read_jacobian(datafile, residuals, "jac_r", "{{-1, 0}, {-20*x[0], 10}}", problem.N,
+                                                problem.parameters); // Jacobian of r
+
+    // The objective is f = 1/2 ||r||^2 and its gradient is J^T r
+    scalar_function f_ls = [residuals](const vector_type &x) -> scalar_type
+    { return 0.5 * residuals(x).squaredNorm(); };
+    vector_function grad_f_ls = [residuals, jac_r](const vector_type &x) -> vector_type
+    { return jac_r(x).transpose() * residuals(x); };
+
+    params = {
+        f_ls,
+        grad_f_ls,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        residuals,
+        jac_r,
+        lambda,
+    };
+}
+
+/// @brief Reads the parameters of the root finding methods
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the root finding methods
+void read(const GetPot &datafile, const Problem &problem, RootFindingParams &params)
+{
+    // Root finding specific paramters
+    const string_type system_str = datafile("system", "{2*x[0] - x[1] - exp(-x[0]), -x[0] + 2*x[1] - exp(-x[1])}"); // System F
+    std::cout << "System to be solved: " << system_str << " = 0" << std::endl;
+    muParserXVectorInterface system(system_str, problem.N, problem.parameters);      // Initialize the system with muparserx
+    const scalar_type h_krylov = datafile("h_krylov", 1e-7);         // Step for the directional differences
+    const int_type krylov_dimension = datafile("krylov_dimension", 20); // Maximum dimension of the Krylov subspace
+    const int_type broyden_memory = datafile("broyden_memory", 20);     // Maximum number of stored Broyden corrections
+
+    const matrix_function jac_F = read_jacobian(datafile, system, "jac_F", "{{2 + exp(-x[0]), -1}, {-1, 2 + exp(-x[1])}}",
+                                                problem.N, problem.parameters); // Jacobian of F
+
+    // The merit function is f = 1/2 ||F||^2 and its gradient is J^T F
+    scalar_function f_merit = [system](const vector_type &x) -> scalar_type
+    { return 0.5 * system(x).squaredNorm(); };
+    vector_function grad_f_merit = [system, jac_F](const vector_type &x) -> vector_type
+    { return jac_F(x).transpose() * system(x); };
+
+    params = {
+        f_merit,
+        grad_f_merit,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        system,
+        h_krylov,
+        krylov_dimension,
+        broyden_memory,
+    };
+}
+
+/// @brief Reads the parameters of block coordinate descent
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of block coordinate descent
+void read(const GetPot &datafile, const Problem &problem, BlockCoordinateDescentParams &params)
+{
+    // Block coordinate descent specific paramters
+    const int_type block_size = std::max(1, datafile("block_size", 1)); // Number of coordinates of each block
+    const scalar_type h = datafile("h", 1e-2);                          // Step for the partial derivatives
+    const scalar_type sigma = datafile("sigma", 0.1);                   // Parameter for the Armijo rule
+    const int_type n = problem.initial_condition.size();
+
+    // Blocks of consecutive coordinates
+    std::vector<std::vector<index_type>> blocks;
+    for (int_type i = 0; i < n; i += block_size)
     {
-        auto *p = dynamic_cast<HeavyBallParams *>(&params);
-        // Heavy ball specific paramters
-        const scalar_type eta = datafile("eta", 0.9);       // Memory parameter for Heavy ball
-        (*p) = {
-            f,
-            grad_f,
-            initial_condition,
-            tolerance_r,
-            tolerance_s,
-            initial_step,
-            max_iterations,
-            minimum_step,
-            mu,
-            eta,
-        };
-        return;
+        blocks.emplace_back();
+        for (int_type j = i; j < std::min(n, i + block_size); ++j)
+            blocks.back().push_back(j);
     }
 
-    else if (dynamic_cast<NesterovParams *>(&params) != nullptr)
+    // Terms of f that depend on each block and blocks that can be updated together
+    const std::vector<Term> terms = additive_terms(problem.f_str);
+    const std::vector<std::vector<index_type>> colors = color_blocks(blocks, terms, n);
+    std::vector<scalar_function> block_functions;
+    for (const auto &block : blocks)
     {
-        auto *p = dynamic_cast<NesterovParams *>(&params);
-        // Nesterov specific paramters
-        const scalar_type eta = datafile("eta_nest", 0.9);   // Memory parameter for Nesterov
-        (*p) = {
-            f,
-            grad_f,
-            initial_condition,
-            tolerance_r,
-            tolerance_s,
-            initial_step,
-            max_iterations,
-            minimum_step,
-            mu,
-            eta,
-        };
-        return;
+        string_type f_b;
+        for (const Term &term : terms)
+        {
+            if (std::find_first_of(term.variables.begin(), term.variables.end(), block.begin(), block.end()) == term.variables.end())
+                continue;
+            f_b += (f_b.empty() ? (term.negative ? "-" : "") : (term.negative ? " - " : " + ")) + ("(" + term.expression + ")");
+        }
+        block_functions.push_back(muParserXScalarInterface(f_b.empty() ? "0" : f_b, n, problem.parameters));
     }
+    std::cout << "Blocks: " << blocks.size() << ", colors (blocks updated concurrently): " << colors.size() << std::endl;
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        blocks,
+        colors,
+        block_functions,
+        h,
+        sigma,
+    };
+}
+
+/// @brief Reads the parameters of the variance reduced methods
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the variance reduced methods
+void read(const GetPot &datafile, const Problem &problem, VarianceReducedParams &params)
+{
+    // Variance reduced methods specific paramters
+    const int_type batch_size = datafile("batch_size", 1); // Terms in each mini-batch
+    const int_type epochs = datafile("epochs", 100);       // Number of epochs
+    const StochasticObjective objective = read_stochastic_objective(datafile, problem.N, problem.parameters);
+
+    params = {
+        [objective](const vector_type &x)
+        { return objective(x); },
+        [objective](const vector_type &x)
+        { return objective.grad(x); },
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        epochs,
+        problem.minimum_step,
+        objective,
+        batch_size,
+    };
+}
+
+/// @brief Reads the parameters of the derivative-free trust region method
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the derivative-free trust region method
+void read(const GetPot &datafile, const Problem &problem, TrustRegionDFOParams &params)
+{
+    // Derivative-free trust region specific paramters
+    const int_type interpolation_points = datafile("interpolation_points", 2 * problem.N + 1); // Number of interpolation points
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        interpolation_points,
+    };
+}
+
+/// @brief Reads the parameters of DIRECT
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of DIRECT
+void read(const GetPot &datafile, const Problem &problem, DirectParams &params)
+{
+    // DIRECT specific paramters
+    const scalar_type epsilon = datafile("epsilon", 1e-4);   // Minimum relative improvement
+    const auto [lower_bounds, upper_bounds] = read_bounds(datafile, problem.N); // Box
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        lower_bounds,
+        upper_bounds,
+        epsilon,
+    };
+}
+
+/// @brief Reads the parameters of CMA-ES
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of CMA-ES
+void read(const GetPot &datafile, const Problem &problem, CMAESParams &params)
+{
+    // CMA-ES specific paramters
+    const int_type population_size = datafile("population_size", 0); // Samples per generation (0 for the default)
+    const int_type restarts = datafile("restarts", 9);               // Maximum number of restarts (IPOP)
 
-    else if (dynamic_cast<AdamParams *>(&params) != nullptr)
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        population_size,
+        restarts,
+    };
+}
+
+/// @brief Reads the parameters of differential evolution
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of differential evolution
+void read(const GetPot &datafile, const Problem &problem, DifferentialEvolutionParams &params)
+{
+    // Differential evolution specific paramters
+    const int_type population_size = datafile("population_size", 0);             // Members of each island (0 for the default)
+    const int_type islands = datafile("islands", 4);                             // Number of islands
+    const scalar_type differential_weight = datafile("differential_weight", 0.5); // Scale of the difference vectors
+    const scalar_type crossover_rate = datafile("crossover_rate", 0.9);           // Crossover probability
+    const int_type migration_interval = datafile("migration_interval", 20);       // Generations between migrations
+    const auto [lower_bounds, upper_bounds] = read_bounds(datafile, problem.N);          // Box
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        lower_bounds,
+        upper_bounds,
+        population_size,
+        islands,
+        differential_weight,
+        crossover_rate,
+        migration_interval,
+    };
+}
+
+/// @brief Reads the parameters of particle swarm
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of particle swarm
+void read(const GetPot &datafile, const Problem &problem, ParticleSwarmParams &params)
+{
+    // Particle swarm specific paramters
+    const int_type population_size = datafile("population_size", 0); // Number of particles (0 for the default)
+    const scalar_type inertia = datafile("inertia", 0.7298);         // Inertia weight
+    const scalar_type cognitive = datafile("cognitive", 1.49618);    // Acceleration towards the personal best
+    const scalar_type social = datafile("social", 1.49618);          // Acceleration towards the global best
+    const auto [lower_bounds, upper_bounds] = read_bounds(datafile, problem.N); // Box
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        lower_bounds,
+        upper_bounds,
+        population_size,
+        inertia,
+        cognitive,
+        social,
+    };
+}
+
+/// @brief Reads the parameters of the RBF surrogate method
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the RBF surrogate method
+void read(const GetPot &datafile, const Problem &problem, RBFSurrogateParams &params)
+{
+    // RBF surrogate specific paramters
+    const int_type batch_size = datafile("surrogate_batch", 4);        // Points evaluated in every round
+    const int_type initial_points = datafile("initial_points", 0);     // Points of the initial design (0 for the default)
+    const string_type archive = datafile("archive", "");               // File of the evaluation archive
+    const auto [lower_bounds, upper_bounds] = read_bounds(datafile, problem.N); // Box
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        lower_bounds,
+        upper_bounds,
+        batch_size,
+        initial_points,
+        archive,
+    };
+}
+
+/// @brief Reads the parameters of the interior point method
+/// @param datafile GetPot object with the parameters
+/// @param problem data of the problem
+/// @param params parameters of the interior point method
+void read(const GetPot &datafile, const Problem &problem, InteriorPointParams &params)
+{
+    // Interior point specific paramters
+    const auto [eq_constraints, jac_eq_constraints] = read_constraints(datafile, "eq_constraints", problem.N, problem.parameters);       // h(x) = 0
+    const auto [ineq_constraints, jac_ineq_constraints] = read_constraints(datafile, "ineq_constraints", problem.N, problem.parameters); // g(x) <= 0
+
+    // Sparsity structure of the KKT system, from the text of the expressions
+    std::vector<std::vector<index_type>> term_variables, eq_variables, ineq_variables;
+    if (!problem.stochastic)
+        for (const Term &term : additive_terms(problem.f_str))
+            term_variables.push_back(term.variables);
+    for (const string_type &element : list_elements(datafile("eq_constraints", "")))
+        eq_variables.push_back(variables(element));
+    for (const string_type &element : list_elements(datafile("ineq_constraints", "")))
+        ineq_variables.push_back(variables(element));
+
+    params = {
+        problem.f,
+        problem.grad_f,
+        problem.initial_condition,
+        problem.tolerance_r,
+        problem.tolerance_s,
+        problem.initial_step,
+        problem.max_iterations,
+        problem.minimum_step,
+        eq_constraints,
+        jac_eq_constraints,
+        ineq_constraints,
+        jac_ineq_constraints,
+        term_variables,
+        eq_variables,
+        ineq_variables,
+    };
+}
+
+/// @brief Describes a method in the solver registry, with the reader of its parameters
+/// @param method name of the method in the data file
+/// @param description keys that select the method and its variant
+template <typename P>
+void describe(const string_type &method, const SolverRegistry::Description &description)
+{
+    SolverRegistry::instance().describe<P>(method, description, [](const GetPot &datafile, Params &params)
+                                           { read(datafile, read_problem(datafile), static_cast<P &>(params)); });
+}
+
+// Title, default selection and keys of the method strings of every method in the data file
+const bool readers_described = []
+{
+    describe<GradientDescentParams>("gradient_descent", {"GRADIENT DESCENT", true, "gradient_method_t", "Armijo rule"});
+    describe<HeavyBallParams>("heavy_ball", {"HEAVY BALL", true, "heavy_ball_t", "Exponential decay", "heavy_ball_s", "Constant"});
+    describe<NesterovParams>("nesterov", {"NESTEROV", true, "nesterov_t", "Exponential decay", "nesterov_s", "Constant"});
+    describe<AdamParams>("adam", {"ADAM", true, "adam_t", "Exponential decay"});
+    describe<LevenbergMarquardtParams>("levenberg_marquardt", {"LEVENBERG-MARQUARDT", false, "levenberg_marquardt_t", "Levenberg-Marquardt"});
+    describe<RootFindingParams>("root_finding", {"ROOT FINDING", false, "root_finding_t", "Broyden"});
+    describe<BlockCoordinateDescentParams>("block_coordinate_descent", {"BLOCK COORDINATE DESCENT", false, "block_coordinate_descent_t", "Cyclic"});
+    describe<VarianceReducedParams>("variance_reduced", {"VARIANCE REDUCED STOCHASTIC GRADIENT", false, "variance_reduced_t", "SVRG"});
+    describe<TrustRegionDFOParams>("trust_region_dfo", {"DERIVATIVE-FREE TRUST REGION"});
+    describe<DirectParams>("direct", {"DIRECT"});
+    describe<CMAESParams>("cma_es", {"CMA-ES", false, "cma_es_t", "Standard"});
+    describe<DifferentialEvolutionParams>("differential_evolution", {"DIFFERENTIAL EVOLUTION", false, "differential_evolution_t", "rand/1/bin"});
+    describe<ParticleSwarmParams>("particle_swarm", {"PARTICLE SWARM", false, "particle_swarm_t", "Inertia"});
+    describe<RBFSurrogateParams>("rbf_surrogate", {"RBF SURROGATE", false, "rbf_surrogate_t", "Cubic"});
+    describe<InteriorPointParams>("interior_point", {"INTERIOR POINT"});
+    return true;
+}();
+
+/// @brief Reads the parameters of a method described in the solver registry
+/// @param datafile GetPot object with the parameters
+/// @param params parameters of the method (of a described type)
+void read(const GetPot &datafile, Params &params)
+{
+    if (!SolverRegistry::instance().read(datafile, params))
+        std::cerr << "No reader for the parameters of the method " << SolverRegistry::instance().name(params) << std::endl;
+}
+
+/// @brief Reads the options of the multi-start driver
+/// @param datafile GetPot object with the options
+/// @param options options of the multi-start driver
+void read(const GetPot &datafile, MultiStartOptions &options)
+{
+    int_type N = datafile.vector_variable_size("initial_condition"); // Dimension of the problem
+    if (N == 0)
+        N = 2; // Dimension of the default initial condition
+
+    std::tie(options.lower_bounds, options.upper_bounds) = read_bounds(datafile, N); // Box of the starting points
+    options.starts = datafile("starts", 16);                                         // Number of starting points
+    options.prune_interval = datafile("prune_interval", 10);                         // Evaluations between two pruning checks
+    options.cluster_radius = datafile("cluster_radius", 1e-3);                       // Radius of the clusters of minima
+    options.scheduler_threads = datafile("scheduler_threads", 0);                    // Threads of the coroutine scheduler
+}
+
+/// @brief Reads the options of the basin hopping driver
+/// @param datafile GetPot object with the options
+/// @param options options of the basin hopping driver
+void read(const GetPot &datafile, BasinHoppingOptions &options)
+{
+    options.hops = datafile("hops", 100);                        // Number of hops of each chain
+    options.step_size = datafile("step_size", 0.5);              // Half width of the perturbations
+    options.temperature = datafile("temperature", 1.0);          // Temperature of the (coldest) chain
+    options.chains = datafile("chains", 4);                      // Number of chains
+    options.max_temperature = datafile("max_temperature", 10.0); // Temperature of the hottest chain
+    options.swap_interval = datafile("swap_interval", 10);       // Hops between two rounds of swaps
+}
+
+/// @brief Reads the constraints and the options of the augmented Lagrangian driver
+/// @param datafile GetPot object with the constraints and the options
+/// @param options constraints and options of the augmented Lagrangian driver
+void read(const GetPot &datafile, AugmentedLagrangianOptions &options)
+{
+    int_type N = datafile.vector_variable_size("initial_condition"); // Dimension of the problem
+    if (N == 0)
+        N = 2; // Dimension of the default initial condition
+
+    const Parameters parameters = read_parameters(datafile); // Named parameters of the expressions
+    std::tie(options.eq_constraints, options.jac_eq_constraints) = read_constraints(datafile, "eq_constraints", N, parameters);       // h(x) = 0
+    std::tie(options.ineq_constraints, options.jac_ineq_constraints) = read_constraints(datafile, "ineq_constraints", N, parameters); // g(x) <= 0
+    options.penalty = datafile("penalty", 10.0);                           // Initial penalty parameter
+    options.penalty_growth = datafile("penalty_growth", 10.0);             // Growth of the penalty parameter
+    options.outer_iterations = datafile("outer_iterations", 20);           // Maximum number of outer iterations
+    options.constraint_tolerance = datafile("constraint_tolerance", 1e-6); // Tolerance on the violation
+}
+
+/// @brief Reads the options of the parameter sweep driver
+/// @param datafile GetPot object with the options
+/// @param options options of the sweep driver
+void read(const GetPot &datafile, SweepOptions &options)
+{
+    int_type N = datafile.vector_variable_size("initial_condition"); // Dimension of the problem
+    if (N == 0)
+        N = 2; // Dimension of the default initial condition
+
+    options.parameter = datafile("parameter", "p");         // Name of the parameter
+    options.start = datafile("parameter_start", 0.0);       // First value of the parameter
+    options.end = datafile("parameter_end", 1.0);           // Last value of the parameter
+    options.points = datafile("parameter_points", 11);      // Number of values of the parameter
+    options.segments = datafile("segments", 4);             // Segments solved in parallel
+
+    // Every segment parses its own copy of f (and of its gradient), with its own copy of the parameters
+    const Parameters parameters = read_parameters(datafile);
+    options.objective = [objective = read_objective(datafile), parameters, N, parameter = options.parameter]()
     {
-        auto *p = dynamic_cast<AdamParams *>(&params);
-        // Adam specific paramters
-        const scalar_type beta1 = datafile("beta1", 0.9);     // Exponential decay rate for 1st moment estimate
-        const scalar_type beta2 = datafile("beta2", 0.999);   // Exponential decay rate for 2nd moment estimate
-        (*p) = {
-            f,
-            grad_f,
-            initial_condition,
-            tolerance_r,
-            tolerance_s,
-            initial_step,
-            max_iterations,
-            minimum_step,
-            mu,
-            beta1,
-            beta2,
-        };
-        return;
-    }
-    
-}
\ No newline at end of file
+        Parameters segment = parameters.clone();
+        segment.set(parameter, 0.0);
+        const auto [f, grad_f] = objective.parse(N, segment);
+        return ParametricObjective{f, grad_f, [segment, parameter](scalar_type p) mutable
+                                   { segment.set(parameter, p); }};
+    };
+}
@@ -29,186 +29,55 @@ void run_solver(const Method &solver)
 }
 
 /**
- * @brief Runs the specified optimization method based on given parameters.
+ * @brief Builds the specified optimization method based on given parameters.
+ *
+ * The solver is found in the registry of the methods (see SolverRegistry)
+ * from the type of the parameters and the method strings.
  *
  * @param params The parameters for the optimization method.
  * @param method_t The primary optimization method type (e.g., "Exponential decay", "Inverse decay").
  * @param method_s (Optional) The secondary strategy for some methods (e.g., "Dynamic", "Constant").
+ * @param adjust (Optional) A modification of the copy of the parameters stored in the solver.
+ * @return The solver, or nullptr if the method type is invalid.
  */
-void run(const Params &params, const string_type &method_t, const string_type &method_s)
+std::unique_ptr<Method> make_solver(const Params &params, const string_type &method_t, const string_type &method_s,
+                                    const std::function<void(Params &)> &adjust)
 {
-    if (dynamic_cast<const GradientDescentParams *>(&params) != nullptr)
-    {
-        const auto *p = dynamic_cast<const GradientDescentParams *>(&params);
-        if (method_t == "Exponential decay")
-        {
-            // Runs gradient descent with exponential step decay.
-            GradientDescent<GradientDescentType::exponential> solver(*p);
-            run_solver(solver);
-        }
-        else if (method_t == "Inverse decay")
-        {
-            // Runs gradient descent with inverse step decay.
-            GradientDescent<GradientDescentType::inverse> solver(*p);
-            run_solver(solver);
-        }
-        else if (method_t == "Armijo rule")
-        {
-            // Runs gradient descent using the Armijo rule for step size selection.
-            GradientDescent<GradientDescentType::armijo> solver(*p);
-            run_solver(solver);
-        }
-        else
-        {
-            std::cerr << "Invalid gradient method type" << std::endl;
-        }
-    }
-    else if (dynamic_cast<const HeavyBallParams *>(&params) != nullptr)
-    {
-        const auto *p = dynamic_cast<const HeavyBallParams *>(&params);
-        if (method_t == "Exponential decay")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs heavy ball with exponential step decay and dynamic memory.
-                HeavyBall<HeavyBallType::exponential, HeavyBallStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs heavy ball with exponential step decay and constant memory.
-                HeavyBall<HeavyBallType::exponential, HeavyBallStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-        else if (method_t == "Inverse decay")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs heavy ball with inverse step decay and dynamic memory.
-                HeavyBall<HeavyBallType::inverse, HeavyBallStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs heavy ball with inverse step decay and constant memory.
-                HeavyBall<HeavyBallType::inverse, HeavyBallStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-        else if (method_t == "Constant")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs heavy ball with constant step size and dynamic memory.
-                HeavyBall<HeavyBallType::constant, HeavyBallStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs heavy ball with constant step size and constant memory.
-                HeavyBall<HeavyBallType::constant, HeavyBallStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-    }
-    else if (dynamic_cast<const NesterovParams *>(&params) != nullptr)
-    {
-        const auto *p = dynamic_cast<const NesterovParams *>(&params);
-        if (method_t == "Exponential decay")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs Nesterov's method with exponential step decay and dynamic memory.
-                Nesterov<NesterovType::exponential, NesterovStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs Nesterov's method with exponential step decay and constant memory.
-                Nesterov<NesterovType::exponential, NesterovStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-        else if (method_t == "Inverse decay")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs Nesterov's method with inverse step decay and dynamic memory.
-                Nesterov<NesterovType::inverse, NesterovStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs Nesterov's method with inverse step decay and constant memory.
-                Nesterov<NesterovType::inverse, NesterovStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-        else if (method_t == "Constant")
-        {
-            if (method_s == "Dynamic")
-            {
-                // Runs Nesterov's method with constant step size and dynamic memory.
-                Nesterov<NesterovType::constant, NesterovStrategy::dynamic> solver(*p);
-                run_solver(solver);
-            }
-            else if (method_s == "Constant")
-            {
-                // Runs Nesterov's method with constant step size and constant memory.
-                Nesterov<NesterovType::constant, NesterovStrategy::constant> solver(*p);
-                run_solver(solver);
-            }
-            else
-            {
-                std::cerr << "Invalid method type" << std::endl;
-                return;
-            }
-        }
-    }
-    else if (dynamic_cast<const AdamParams *>(&params) != nullptr)
+    const SolverRegistry &registry = SolverRegistry::instance();
+    std::unique_ptr<Method> solver = registry.make(params, method_t, method_s, adjust);
+    if (!solver)
+        std::cerr << "Invalid method type for " << registry.name(params) << ": " << method_t
+                  << (method_s.empty() ? "" : ", " + method_s) << std::endl;
+    return solver;
+}
+
+/**
+ * @brief Prints the registered methods and their variants.
+ */
+void print_methods()
+{
+    std::cout << "Available methods (method, method_t, method_s):" << std::endl;
+    for (const SolverRegistry::Entry &entry : SolverRegistry::instance().available())
     {
-        const auto *p = dynamic_cast<const AdamParams *>(&params);
-        if (method_t == "Dynamic")
-        {
-            // Runs Adam with dynamic step size.
-            Adam<AdamType::dynamic> solver(*p);
-            run_solver(solver);
-        }
-        else if (method_t == "Constant")
-        {
-            // Runs Adam with constant step size.
-            Adam<AdamType::constant> solver(*p);
-            run_solver(solver);
-        }
-        else
-        {
-            std::cerr << "Invalid method type" << std::endl;
-        }
+        std::cout << "  " << entry.method;
+        if (!entry.method_t.empty())
+            std::cout << ", " << entry.method_t;
+        if (!entry.method_s.empty())
+            std::cout << ", " << entry.method_s;
+        std::cout << std::endl;
     }
 }
+
+/**
+ * @brief Runs the specified optimization method based on given parameters.
+ *
+ * @param params The parameters for the optimization method.
+ * @param method_t The primary optimization method type (e.g., "Exponential decay", "Inverse decay").
+ * @param method_s (Optional) The secondary strategy for some methods (e.g., "Dynamic", "Constant").
+ */
+void run(const Params &params, const string_type &method_t, const string_type &method_s)
+{
+    const std::unique_ptr<Method> solver = make_solver(params, method_t, method_s);
+    if (solver)
+        run_solver(*solver);
+}
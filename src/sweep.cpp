@@ -0,0 +1,67 @@
+#include "sweep.hpp"
+#include "run.hpp"
+#include <algorithm> // For std::clamp
+#include <tbb/parallel_for.h>
+
+/**
+ * @brief Minimizes f(x; p) for a range of values of a parameter p and prints the minimizers.
+ *
+ * The values of p are split in contiguous segments, solved concurrently
+ * (one TBB task each). Every segment has its own copy of the objective, so
+ * the expressions are parsed once per segment and every solve only sets the
+ * value of p. Inside a segment the values are solved in order, each solve
+ * warm started from the minimizer of the previous value (continuation), so
+ * the solver follows a branch of minima and needs few iterations when p
+ * changes little. The first value of every segment starts from the initial
+ * condition.
+ *
+ * @param params The parameters of the method.
+ * @param method_t The primary optimization method type.
+ * @param method_s The secondary strategy for some methods.
+ * @param options The options of the sweep driver.
+ */
+void run_sweep(const Params &params, const string_type &method_t, const string_type &method_s,
+               const SweepOptions &options)
+{
+    const std::unique_ptr<Method> prototype = make_solver(params, method_t, method_s);
+    if (!prototype)
+        return;
+
+    const index_type points = std::max<int_type>(options.points, 1);
+    const index_type segments = std::clamp<index_type>(options.segments, 1, points);
+    prototype->print();
+    std::cout << "Sweep of " << options.parameter << " from " << options.start << " to " << options.end << std::endl;
+    std::cout << "points: " << points << std::endl;
+    std::cout << "segments: " << segments << std::endl;
+
+    std::vector<scalar_type> values(points);
+    for (index_type k = 0; k < points; ++k)
+        values[k] = points > 1 ? options.start + (options.end - options.start) * k / (points - 1) : options.start;
+    std::vector<vector_type> minima(points);
+    std::vector<scalar_type> minimum_values(points);
+
+    {
+        SilentCout silent;
+        tbb::parallel_for(index_type(0), segments, [&](index_type s)
+                          {
+                              const ParametricObjective objective = options.objective();
+                              vector_type x = params.initial_condition;
+                              for (index_type k = s * points / segments; k < (s + 1) * points / segments; ++k)
+                              {
+                                  objective.set_parameter(values[k]);
+                                  const auto solver = make_solver(params, method_t, method_s, [&](Params &p)
+                                                                  {
+                                                                      p.f = objective.f;
+                                                                      p.grad_f = objective.grad_f;
+                                                                      p.initial_condition = x; });
+                                  x = (*solver)();
+                                  minima[k] = x;
+                                  minimum_values[k] = objective.f(x);
+                              } }, tbb::simple_partitioner());
+    }
+
+    Eigen::IOFormat commaFormat(Eigen::StreamPrecision, 0, ",", ",", "", "", "(", ")");
+    for (index_type k = 0; k < points; ++k)
+        std::cout << options.parameter << " = " << values[k] << ": x = " << minima[k].format(commaFormat)
+                  << ", f = " << minimum_values[k] << std::endl;
+}